@@ -3,12 +3,28 @@
 layout(location = 0) in vec3 _position;
 layout(location = 1) in vec2 _texCoord0;
 
+// Per sprite, the position and rotation on the previous tick and on the
+// current one, and the scale with the texture size folded in.
+layout(location = 2) in vec2 _previous_position;
+layout(location = 3) in vec2 _current_position;
+layout(location = 4) in float _previous_rotation;
+layout(location = 5) in float _current_rotation;
+layout(location = 6) in vec2 _scale;
+
 out vec2 texCoord0;
 
 uniform mat4 view_projection;
-uniform mat4 transform;
+uniform float alpha;
 
 void main() {
-	gl_Position = view_projection * transform * vec4(_position, 1.0);
+	vec2 position = mix(_previous_position, _current_position, alpha);
+	float rotation = mix(_previous_rotation, _current_rotation, alpha);
+
+	vec2 scaled = _position.xy * _scale;
+	float c = cos(rotation);
+	float s = sin(rotation);
+	vec2 world = vec2(c * scaled.x - s * scaled.y, s * scaled.x + c * scaled.y) + position;
+
+	gl_Position = view_projection * vec4(world, _position.z, 1.0);
 	texCoord0 = _texCoord0;
 }
\ No newline at end of file
@@ -3,11 +3,11 @@
 layout(location = 0) in vec3 position;
 
 uniform mat4 view_projection;
-uniform mat4 transform;
+uniform mat3x2 transform;
 
 out vec3 _position;
 
 void main() {
-	gl_Position = view_projection * transform * vec4(position, 1.0);
+	gl_Position = view_projection * vec4(transform * vec3(position.xy, 1.0), position.z, 1.0);
 	_position = position;
 }
\ No newline at end of file
@@ -6,9 +6,9 @@ layout(location = 1) in vec2 _texture_coordinate0;
 out vec2 texture_coordinate0;
 
 uniform mat4 view_projection;
-uniform mat4 transform;
+uniform mat3x2 transform;
 
 void main() {
-	gl_Position = view_projection * transform * vec4(_position, 1.0);
+	gl_Position = view_projection * vec4(transform * vec3(_position.xy, 1.0), _position.z, 1.0);
 	texture_coordinate0 = _texture_coordinate0;
 }
\ No newline at end of file
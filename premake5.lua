@@ -6,7 +6,7 @@ end
 
 workspace "FlappyBird"
 	configurations { 'Debug', 'Release' }
-	platforms { 'Win64', 'Android64' }
+	platforms { 'Win64', 'Linux64', 'Android64' }
 	location 'build'
 
 project 'flappy-bird'
@@ -21,13 +21,16 @@ project 'flappy-bird'
 		'{COPYDIR} %[./assets] %[%{!cfg.buildtarget.directory}/assets]'
 	}
 
+	-- Linux builds use the system packages, so the directories are optional there.
+	local uses_system_libraries = os.target() == 'linux'
+
 	local include_dir = os.getenv('INCLUDE_DIR')
-	assert(include_dir ~= nil, 'INCLUDE_DIR environment variable has not been defined.')
+	assert(include_dir ~= nil or uses_system_libraries, 'INCLUDE_DIR environment variable has not been defined.')
 	includedirs { include_dir }
 
     filter 'configurations:Release'
 		local lib_dir = os.getenv('LIB_DIR')
-		assert(lib_dir ~= nil, 'LIB_DIR environment variable has not been defined.')
+		assert(lib_dir ~= nil or uses_system_libraries, 'LIB_DIR environment variable has not been defined.')
 		libdirs { lib_dir } 
 
         optimize 'On'
@@ -43,6 +46,15 @@ project 'flappy-bird'
         system 'Windows'
         architecture 'x86_64'
 
+	filter 'platforms:Linux64'
+		system 'linux'
+		architecture 'x86_64'
+
+	filter 'system:linux'
+		links { 'SDL2', 'GLEW', 'GL', 'freetype', 'pthread' }
+		includedirs { '/usr/include/freetype2' }
+		defines { 'LINUX' }
+
 	filter 'system:Windows'
 		links { 'shell32', 'opengl32' }
 		defines { 'WIN32', 'UNICODE' }
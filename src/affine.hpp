@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+// A 2D transform in six floats: the two basis columns then the translation.
+// Laid out like GLSL's column major `mat3x2`, so it can be uploaded as is.
+struct Affine {
+	glm::vec2 x_axis = glm::vec2(1.0f, 0.0f);
+	glm::vec2 y_axis = glm::vec2(0.0f, 1.0f);
+	glm::vec2 translation = glm::vec2(0.0f);
+
+	// Scales, then rotates anticlockwise by `rotation` radians, then moves to
+	// `position`.
+	static Affine from(glm::vec2 position, float rotation, glm::vec2 scale) {
+		const float cos_rotation = cosf(rotation);
+		const float sin_rotation = sinf(rotation);
+		return Affine {
+			.x_axis = glm::vec2(cos_rotation, sin_rotation) * scale.x,
+			.y_axis = glm::vec2(-sin_rotation, cos_rotation) * scale.y,
+			.translation = position
+		};
+	}
+
+	// Scales in local space, before the rest of the transform.
+	Affine scaled(glm::vec2 scale) const {
+		return Affine {
+			.x_axis = this->x_axis * scale.x,
+			.y_axis = this->y_axis * scale.y,
+			.translation = this->translation
+		};
+	}
+
+	const float *data() const {
+		return &this->x_axis.x;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Counts heap allocations made through `operator new` so the steady state can
+// be checked for them. Only debug builds replace the global operators, in
+// release the counts stay at zero.
+//
+// The replacements below are definitions, so this must be included by exactly
+// one translation unit.
+namespace Allocation_Tracker {
+	#ifndef NDEBUG
+	constexpr bool is_enabled = true;
+	#else
+	constexpr bool is_enabled = false;
+	#endif
+
+	inline thread_local uint64_t thread_count = 0;
+	inline std::atomic<uint64_t> total_count = 0;
+
+	inline void record() {
+		thread_count++;
+		total_count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Allocations made by the calling thread so far. Take the difference of
+	// two calls to count the allocations in between.
+	inline uint64_t get_thread_count() {
+		return thread_count;
+	}
+};
+
+// Allocation counts over a run of frames, or of ticks.
+struct Allocation_Report {
+	uint64_t frame_count = 0;
+	uint64_t frames_with_allocations = 0;
+	uint64_t allocation_count = 0;
+	uint64_t max_per_frame = 0;
+
+	void record(uint64_t count) {
+		this->frame_count++;
+		this->allocation_count += count;
+		if (count > 0) {
+			this->frames_with_allocations++;
+		}
+		if (count > this->max_per_frame) {
+			this->max_per_frame = count;
+		}
+	}
+};
+
+#ifndef NDEBUG
+// The other forms would forward to the plain and aligned ones by default, but
+// sanitizers supply their own for any left out, so every form is replaced.
+void *operator new(size_t size) {
+	Allocation_Tracker::record();
+	void *memory = malloc(size != 0 ? size : 1);
+	if (memory == nullptr) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void *operator new[](size_t size) {
+	return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+	try {
+		return operator new(size);
+	} catch (...) {
+		return nullptr;
+	}
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void *memory) noexcept {
+	free(memory);
+}
+
+void operator delete[](void *memory) noexcept {
+	operator delete(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+	operator delete(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept {
+	operator delete(memory);
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+	Allocation_Tracker::record();
+
+	// `aligned_alloc` wants the size to be a multiple of the alignment.
+	const size_t align = (size_t)alignment;
+	const size_t aligned_size = ((size != 0 ? size : 1) + align - 1) & ~(align - 1);
+	#ifdef _WIN32
+	void *memory = _aligned_malloc(aligned_size, align);
+	#else
+	void *memory = aligned_alloc(align, aligned_size);
+	#endif
+	if (memory == nullptr) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void operator delete(void *memory, std::align_val_t) noexcept {
+	#ifdef _WIN32
+	_aligned_free(memory);
+	#else
+	free(memory);
+	#endif
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+void operator delete[](void *memory, std::align_val_t alignment) noexcept {
+	operator delete(memory, alignment);
+}
+
+void operator delete(void *memory, size_t, std::align_val_t alignment) noexcept {
+	operator delete(memory, alignment);
+}
+
+void operator delete[](void *memory, size_t, std::align_val_t alignment) noexcept {
+	operator delete(memory, alignment);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+// Linear allocator over memory it doesn't own. Allocating bumps an offset and
+// freeing is only ever done all at once with `reset`, so nothing is tracked
+// per allocation and destructors are never run by the arena.
+struct Arena {
+	uint8_t *base = nullptr;
+	size_t capacity = 0;
+	size_t used = 0;
+
+	// The most that has ever been used, to size the reservation from.
+	size_t high_water = 0;
+
+	void init(void *memory, size_t capacity) {
+		this->base = (uint8_t *)memory;
+		this->capacity = capacity;
+		this->used = 0;
+		this->high_water = 0;
+	}
+
+	// Null if the arena is out of space. `alignment` must be a power of two.
+	void *push(size_t size, size_t alignment = alignof(std::max_align_t)) {
+		const uintptr_t address = (uintptr_t)this->base + this->used;
+		const size_t padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+		if (this->used + padding + size > this->capacity) {
+			return nullptr;
+		}
+
+		void *memory = this->base + this->used + padding;
+		this->used += padding + size;
+		if (this->used > this->high_water) {
+			this->high_water = this->used;
+		}
+
+		return memory;
+	}
+
+	// Constructs a `T` in the arena. Running out of space is a sizing mistake
+	// rather than something to recover from, so it asserts.
+	template<typename T, typename... Args>
+	T *make(Args &&... args) {
+		void *memory = this->push(sizeof(T), alignof(T));
+		assert(memory != nullptr && "Arena is out of space.");
+		return new (memory) T(std::forward<Args>(args)...);
+	}
+
+	// Uninitialised storage for `count` of `T`.
+	template<typename T>
+	T *push_array(size_t count) {
+		T *items = (T *)this->push(sizeof(T) * count, alignof(T));
+		assert(items != nullptr && "Arena is out of space.");
+		return items;
+	}
+
+	void reset() {
+		this->used = 0;
+	}
+};
\ No newline at end of file
@@ -1,9 +1,15 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
+#include <span>
 
+// Fixed capacity, with its storage inline so it never touches the heap. This
+// is also what to reach for where a small vector would be used.
 template<typename T, size_t Size>
 struct Array {
+	static constexpr size_t capacity = Size;
+
 	Array() {}
 
 	size_t length = 0;
@@ -14,7 +20,7 @@ struct Array {
 		return this->data[index];
 	}
 
-	T operator [](size_t index) const {
+	const T &operator [](size_t index) const {
 		assert(index >= 0 && index < Size);
 		return this->data[index];
 	}
@@ -43,8 +49,16 @@ struct Array {
 		return this->data[--this->length];
 	}
 
-	T &push(T value) {
+	T &push(const T &value) {
 		assert(this->length != Size);
 		return this->data[this->length++] = value;
 	}
+
+	std::span<T> view() {
+		return std::span<T>(this->data, this->length);
+	}
+
+	std::span<const T> view() const {
+		return std::span<const T>(this->data, this->length);
+	}
 };
\ No newline at end of file
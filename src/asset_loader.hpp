@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "assets.hpp"
+#include "collision_mask.hpp"
+#include "logger.hpp"
+#include "native_platform.hpp"
+#include "profiler.hpp"
+
+// Reads what the simulation needs from the asset files without a GPU, so
+// runs without a renderer size and collide everything the same way.
+namespace Asset_Loader {
+	// Returns tightly packed RGBA to be freed with `stbi_image_free`, or null
+	// if the file is missing or can't be decoded.
+	inline unsigned char *decode_texture(const Native_Platform &platform, Asset::Texture_ID id, int *width, int *height) {
+		const Asset::Texture &texture = Asset::get_texture(id);
+		const std::string file_path = platform.get_asset_path(texture.location);
+
+		Platform_File *file;
+		platform.load_file(file_path.c_str(), &file);
+		if (file == nullptr) {
+			return nullptr;
+		}
+
+		// Missing channels are filled in by stb_image, so the channel count
+		// isn't needed.
+		int channels_in_texture;
+		unsigned char *pixels = stbi_load_from_memory(
+			(const stbi_uc *)file->contents, 
+			(int)file->content_size, 
+			width, 
+			height, 
+			&channels_in_texture, 
+			4
+		);
+		platform.close_file(&file);
+
+		if (pixels == nullptr) {
+			LOG_ERROR("Could not load texture (%s): %s", texture.location, stbi_failure_reason());
+		}
+		return pixels;
+	}
+
+	// Fills in every texture's size and builds the collision masks. Must run
+	// before any `Game::setup`.
+	inline bool load_simulation_assets(const Native_Platform &platform) {
+		PROFILE_ZONE("Load simulation assets");
+		for (size_t i = 0; i < Asset::texture_data.size(); i++) {
+			const Asset::Texture_ID texture_id = static_cast<Asset::Texture_ID>(i);
+			Asset::Texture &texture = Asset::texture_data[i];
+			unsigned char *pixels = decode_texture(platform, texture_id, &texture.width, &texture.height);
+			if (pixels == nullptr) {
+				return false;
+			}
+
+			Collision_Mask *collision_mask = Asset::get_collision_mask(texture_id);
+			const bool is_mask_built = collision_mask == nullptr || collision_mask->build(pixels, texture.width, texture.height);
+			stbi_image_free(pixels);
+			if (!is_mask_built) {
+				LOG_ERROR("Texture (%s) is too large for a collision mask.", texture.location);
+				return false;
+			}
+		}
+
+		return true;
+	}
+};
\ No newline at end of file
@@ -1,7 +1,16 @@
 #pragma once
 
-struct Audio_Player {
-	virtual void flap() = 0;
-	virtual void score() = 0;
-	virtual void hit() = 0;
+// The sounds the game asks for. Players are picked at compile time, so with
+// `Null_Audio_Player` the calls compile away entirely.
+template<typename T>
+concept Audio_Backend = requires(T audio_player) {
+	audio_player.flap();
+	audio_player.score();
+	audio_player.hit();
+};
+
+struct Null_Audio_Player {
+	void flap() {}
+	void score() {}
+	void hit() {}
 };
\ No newline at end of file
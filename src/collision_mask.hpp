@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "assets.hpp"
+#include "simd.hpp"
+#include "size.hpp"
+
+// One bit per texel, set where the texture is opaque. Each row is packed into
+// a single 64 bit word with bit `x` holding column `x`, so testing a row of
+// one mask against a row of another is a shift and an AND. Row 0 is the top
+// of the image, as it is drawn.
+struct Collision_Mask {
+	static constexpr int max_width = 64;
+	static constexpr int max_height = 512;
+
+	int width = 0;
+	int height = 0;
+	uint64_t rows[max_height];
+
+	// `pixels` is tightly packed RGBA. Textures larger than the mask are
+	// rejected rather than clipped, so nothing silently stops colliding.
+	bool build(const unsigned char *pixels, int width, int height, unsigned char alpha_threshold = 128) {
+		this->width = 0;
+		this->height = 0;
+		if (width > max_width || height > max_height) {
+			return false;
+		}
+
+		for (int y = 0; y < height; y++) {
+			uint64_t row = 0;
+			for (int x = 0; x < width; x++) {
+				const unsigned char alpha = pixels[((size_t)y * width + x) * 4 + 3];
+				if (alpha >= alpha_threshold) {
+					row |= (uint64_t)1 << x;
+				}
+			}
+			this->rows[y] = row;
+		}
+
+		this->width = width;
+		this->height = height;
+		return true;
+	}
+
+	// Resamples `source` rotated by `rotation` (radians, anticlockwise) after
+	// scaling by `scale`, into the smallest axis aligned mask that holds it.
+	// Each texel takes the source texel under its centre.
+	void build_transformed(const Collision_Mask &source, float rotation, glm::vec2 scale) {
+		const float cos_rotation = cosf(rotation);
+		const float sin_rotation = sinf(rotation);
+		const float half_width = source.width * fabsf(scale.x) / 2;
+		const float half_height = source.height * fabsf(scale.y) / 2;
+		const float bound_x = fabsf(cos_rotation) * half_width + fabsf(sin_rotation) * half_height;
+		const float bound_y = fabsf(sin_rotation) * half_width + fabsf(cos_rotation) * half_height;
+
+		this->width = glm::min((int)ceilf(bound_x * 2), max_width);
+		this->height = glm::min((int)ceilf(bound_y * 2), max_height);
+
+		for (int y = 0; y < this->height; y++) {
+			uint64_t row = 0;
+			const float local_y = this->height / 2.0f - (y + 0.5f);
+
+			for (int x = 0; x < this->width; x++) {
+				const float local_x = x + 0.5f - this->width / 2.0f;
+
+				// Undo the rotation then the scale to land in the source.
+				const float source_x = (cos_rotation * local_x + sin_rotation * local_y) / scale.x;
+				const float source_y = (-sin_rotation * local_x + cos_rotation * local_y) / scale.y;
+				const int column = (int)floorf(source_x + source.width / 2.0f);
+				const int source_row = (int)floorf(source.height / 2.0f - source_y);
+
+				if (source.is_set(column, source_row)) {
+					row |= (uint64_t)1 << x;
+				}
+			}
+			this->rows[y] = row;
+		}
+	}
+
+	bool is_set(int x, int y) const {
+		if (x < 0 || x >= this->width || y < 0 || y >= this->height) {
+			return false;
+		}
+		return (this->rows[y] >> x) & 1;
+	}
+
+	Size<float> get_size() const {
+		return { .width = (float)this->width, .height = (float)this->height };
+	}
+};
+
+// Masks are placed on whole world units, which are the view's pixels, so a
+// collision is exactly what can be seen on screen.
+inline int get_mask_left(const Collision_Mask &mask, glm::vec2 centre) {
+	return (int)floorf(centre.x - mask.width / 2.0f + 0.5f);
+}
+
+inline int get_mask_top(const Collision_Mask &mask, glm::vec2 centre) {
+	return (int)floorf(centre.y + mask.height / 2.0f + 0.5f);
+}
+
+// `b` can be drawn flipped vertically, as the bottom pipe is. Two rows are
+// tested at a time where SIMD is available.
+inline bool collision_mask_intersection(
+	const Collision_Mask &a,
+	glm::vec2 a_centre,
+	const Collision_Mask &b,
+	glm::vec2 b_centre,
+	bool b_is_flipped
+) {
+	const int a_left = get_mask_left(a, a_centre);
+	const int b_left = get_mask_left(b, b_centre);
+	const int shift = a_left - b_left;
+	if (shift >= b.width || -shift >= a.width) {
+		return false;
+	}
+
+	// Row `a_row` of `a` lines up with row `a_row + row_offset` of `b`.
+	const int row_offset = get_mask_top(b, b_centre) - get_mask_top(a, a_centre);
+	const int first_row = glm::max(0, -row_offset);
+	const int last_row = glm::min(a.height, b.height - row_offset);
+
+	int a_row = first_row;
+	uint64_t overlap = 0;
+
+#if SIMD_SSE
+	// Both lanes share the shift, so it is one shift by a register count.
+	const __m128i left_shift = _mm_cvtsi32_si128(glm::max(shift, 0));
+	const __m128i right_shift = _mm_cvtsi32_si128(glm::max(-shift, 0));
+	__m128i overlaps = _mm_setzero_si128();
+	for (; a_row + 2 <= last_row; a_row += 2) {
+		__m128i a_bits = _mm_loadu_si128((const __m128i *)&a.rows[a_row]);
+		a_bits = _mm_srl_epi64(_mm_sll_epi64(a_bits, left_shift), right_shift);
+
+		// A flipped `b` runs backwards, so its pair of rows is swapped.
+		__m128i b_bits;
+		if (b_is_flipped) {
+			b_bits = _mm_loadu_si128((const __m128i *)&b.rows[b.height - 2 - (a_row + row_offset)]);
+			b_bits = _mm_shuffle_epi32(b_bits, _MM_SHUFFLE(1, 0, 3, 2));
+		} else {
+			b_bits = _mm_loadu_si128((const __m128i *)&b.rows[a_row + row_offset]);
+		}
+
+		overlaps = _mm_or_si128(overlaps, _mm_and_si128(a_bits, b_bits));
+	}
+
+	const bool is_clear = _mm_movemask_epi8(_mm_cmpeq_epi8(overlaps, _mm_setzero_si128())) == 0xFFFF;
+	if (!is_clear) {
+		return true;
+	}
+#endif
+
+	for (; a_row < last_row; a_row++) {
+		const int b_row = b_is_flipped ? b.height - 1 - (a_row + row_offset) : a_row + row_offset;
+		const uint64_t a_bits = shift >= 0 ? a.rows[a_row] << shift : a.rows[a_row] >> -shift;
+		overlap |= a_bits & b.rows[b_row];
+	}
+
+	return overlap != 0;
+}
+
+// Tests a mask against a solid rectangle.
+inline bool collision_mask_rect_intersection(
+	const Collision_Mask &mask,
+	glm::vec2 centre,
+	glm::vec2 rect,
+	Size<float> rect_size
+) {
+	const int left = get_mask_left(mask, centre);
+	const int top = get_mask_top(mask, centre);
+
+	// Columns and rows of the mask the rectangle covers at least partly.
+	const int first_column = glm::max(0, (int)floorf(rect.x - rect_size.width / 2) - left);
+	const int last_column = glm::min(mask.width, (int)ceilf(rect.x + rect_size.width / 2) - left);
+	const int first_row = glm::max(0, top - (int)ceilf(rect.y + rect_size.height / 2));
+	const int last_row = glm::min(mask.height, top - (int)floorf(rect.y - rect_size.height / 2));
+	if (first_column >= last_column || first_row >= last_row) {
+		return false;
+	}
+
+	const int column_count = last_column - first_column;
+	const uint64_t columns = (column_count >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << column_count) - 1) << first_column;
+
+	uint64_t overlap = 0;
+	for (int row = first_row; row < last_row; row++) {
+		overlap |= mask.rows[row] & columns;
+	}
+
+	return overlap != 0;
+}
+
+namespace Asset {
+	// Filled in from the decoded textures, see
+	// `Asset_Loader::load_simulation_assets`.
+	inline Collision_Mask bird_collision_mask;
+	inline Collision_Mask pipe_collision_mask;
+
+	inline Collision_Mask *get_collision_mask(Texture_ID id) {
+		switch (id) {
+			case Texture_ID::bird: return &bird_collision_mask;
+			case Texture_ID::pipe: return &pipe_collision_mask;
+			default: return nullptr;
+		}
+	}
+};
\ No newline at end of file
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "affine.hpp"
 #include "array.hpp"
 #include "size.hpp"
 
@@ -12,7 +16,7 @@ enum class Shape_Type {
 };
 
 struct Shape {
-	glm::mat4 transform = glm::identity<glm::mat4>();
+	Affine transform;
 	Shape_Type type;
 	glm::vec4 colour = glm::vec4(0.0f);
 	union {
@@ -21,8 +25,80 @@ struct Shape {
 	};
 };
 
+using Debug_Shapes = Array<Shape, 16>;
+
+// What one rendered frame cost. Times are real nanoseconds.
+struct Frame_Stats {
+	uint64_t frame_ns = 0;
+	uint64_t sim_ns = 0;
+	uint64_t render_ns = 0;
+
+	// Ticks the simulation published since the previous frame.
+	uint32_t tick_count = 0;
+	uint32_t draw_call_count = 0;
+};
+
+// The latest frames, oldest first once it has wrapped.
+struct Frame_Stats_Window {
+	static constexpr size_t capacity = 90;
+
+	Frame_Stats frames[capacity];
+	uint64_t total_count = 0;
+
+	void record(const Frame_Stats &stats) {
+		this->frames[this->total_count % capacity] = stats;
+		this->total_count++;
+	}
+
+	size_t get_length() const {
+		return this->total_count < capacity ? (size_t)this->total_count : capacity;
+	}
+
+	// `index` 0 is the oldest frame still kept.
+	const Frame_Stats &get(size_t index) const {
+		const uint64_t first = this->total_count - this->get_length();
+		return this->frames[(first + index) % capacity];
+	}
+
+	// Every field summed over the window, divide by `get_length` for the
+	// averages.
+	Frame_Stats get_total() const {
+		Frame_Stats total = {};
+		for (size_t i = 0; i < this->get_length(); i++) {
+			const Frame_Stats &frame = this->frames[i];
+			total.frame_ns += frame.frame_ns;
+			total.sim_ns += frame.sim_ns;
+			total.render_ns += frame.render_ns;
+			total.tick_count += frame.tick_count;
+			total.draw_call_count += frame.draw_call_count;
+		}
+		return total;
+	}
+
+	uint64_t get_max_frame_ns() const {
+		uint64_t max_frame_ns = 0;
+		for (size_t i = 0; i < this->get_length(); i++) {
+			max_frame_ns = this->frames[i].frame_ns > max_frame_ns ? this->frames[i].frame_ns : max_frame_ns;
+		}
+		return max_frame_ns;
+	}
+};
+
 struct Debug_State {
-	bool show_collision_debugger = false;
-	Array<Shape, 16> debug_shapes;
-	float sim_speed = 1.0f;
+	// Set from the render thread and read by the simulation thread.
+	std::atomic<bool> show_collision_debugger = false;
+	std::atomic<float> sim_speed = 1.0f;
+	std::atomic<bool> clear_high_score = false;
+
+	// Only touched by the simulation thread, renderers get a copy through
+	// `Simulation_Snapshot`.
+	Debug_Shapes debug_shapes;
+
+	// Real time the simulation thread has spent running ticks. The render
+	// thread takes the difference between frames.
+	std::atomic<uint64_t> sim_time_ns = 0;
+
+	// Only touched by the render thread.
+	bool show_performance_overlay = false;
+	Frame_Stats_Window frame_stats;
 };
\ No newline at end of file
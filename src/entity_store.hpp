@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "assets.hpp"
+
+// Decides what happens to an entity beyond the generic scroll and wrap, such
+// as picking a new height for a recycled pipe.
+enum class Entity_Kind : uint8_t {
+	cloud,
+	hill,
+	pipe_top,
+	pipe_bottom,
+	ground
+};
+
+// Everything needed to add an entity. Behaviour comes from these values
+// rather than from code per kind.
+struct Entity_Spawn {
+	Entity_Kind kind;
+	Asset::Texture_ID texture;
+	glm::vec2 position = glm::vec2(0.0f);
+	glm::vec2 scale = glm::vec2(1.0f);
+
+	// Units per second, applied whether or not the game is being played.
+	glm::vec2 velocity = glm::vec2(0.0f);
+
+	// Share of the world scroll speed applied while playing.
+	float scroll_scale = 0.0f;
+
+	// Once the entity reaches `recycle_x` it moves `wrap_distance` to the
+	// right and counts as a new entity.
+	float recycle_x = -INFINITY;
+	float wrap_distance = 0.0f;
+};
+
+// The scenery, stored as one array per component so each system walks only
+// the streams it needs. Entities are drawn in the order they were spawned.
+template<size_t Capacity>
+struct Entity_Store {
+	static constexpr size_t capacity = Capacity;
+
+	size_t length = 0;
+
+	glm::vec2 positions[Capacity];
+	float rotations[Capacity];
+	glm::vec2 scales[Capacity];
+
+	// Changes whenever the entity is recycled, so it isn't interpolated from
+	// where it was before.
+	uint32_t versions[Capacity];
+
+	glm::vec2 velocities[Capacity];
+	float scroll_scales[Capacity];
+	float recycle_xs[Capacity];
+	float wrap_distances[Capacity];
+	Asset::Texture_ID textures[Capacity];
+	Entity_Kind kinds[Capacity];
+
+	size_t spawn(const Entity_Spawn &spawn) {
+		assert(this->length != Capacity);
+		const size_t i = this->length++;
+
+		this->positions[i] = spawn.position;
+		this->rotations[i] = 0.0f;
+		this->scales[i] = spawn.scale;
+		this->versions[i] = 0;
+		this->velocities[i] = spawn.velocity;
+		this->scroll_scales[i] = spawn.scroll_scale;
+		this->recycle_xs[i] = spawn.recycle_x;
+		this->wrap_distances[i] = spawn.wrap_distance;
+		this->textures[i] = spawn.texture;
+		this->kinds[i] = spawn.kind;
+		return i;
+	}
+};
\ No newline at end of file
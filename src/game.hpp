@@ -6,159 +6,169 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "game_properties.hpp"
+#include "game_rules.hpp"
 #include "game_state.hpp"
+#include "game_events.hpp"
 #include "persistent_game_state.hpp"
-#include "platform.hpp"
 #include "input.hpp"
 #include "intersection.hpp"
 #include "debug_state.hpp"
-#include "audio_player.hpp"
+#include "collision_mask.hpp"
 
+// Instantiated once per set of rules, see `game_rules.hpp`.
+template<typename Rules>
 struct Game {
+	static_assert(
+		Rules::cloud_count + Rules::hill_count + Rules::pipe_pair_count * 2 + Rules::ground_count <= Scenery::capacity,
+		"The rules spawn more scenery than there is room for."
+	);
+
 	static void setup(Game_State *state) {
-		// Setup the initial pipe positions when we start playing
-		setup_pipe(&state->pipe_pairs[0], Game_Properties::pipe.x_spacing);
-		setup_pipe(&state->pipe_pairs[1], Game_Properties::pipe.x_spacing * 2);
-
-		// Setup initial clouds
-		for (size_t i = 0; i < state->clouds.size(); i++) {
-			Cloud &cloud = state->clouds[i];
-			cloud.type = rand() % 2 == 0 ? Cloud::Type::one : Cloud::Type::two;
-			cloud.speed_scale = rand_range(
-				Game_Properties::cloud.speed_scale_min, 
-				Game_Properties::cloud.speed_scale_max
-			),
-			cloud.position = glm::vec2(
-				rand_range(Game_Properties::cloud.x_min, Game_Properties::cloud.x_max),
-				rand_range(Game_Properties::cloud.y_min, Game_Properties::cloud.y_max)
-			);
-			cloud.scale = get_random_cloud_scale(i, state->clouds.size());
+		Scenery &scenery = state->scenery;
+		const float left_of_view = -(float)Game_Properties::view.width / 2;
+		const float bottom_of_view = -(float)Game_Properties::view.height / 2;
+
+		// Spawned back to front, which is the order they are drawn in.
+
+		// Clouds
+		for (size_t i = 0; i < Rules::cloud_count; i++) {
+			const size_t cloud_i = scenery.spawn({
+				.kind = Entity_Kind::cloud,
+				.texture = Asset::Texture_ID::cloud1,
+				.scroll_scale = Rules::cloud.scroll_modifier,
+				.recycle_x = Rules::cloud.x_min
+			});
+			respawn_cloud(&scenery, cloud_i, rand_range(Rules::cloud.x_min, Rules::cloud.x_max));
 		}
 
-		// Setup hills
+		// Hills
 		{
 			const Asset::Texture hill_texture = Asset::get_texture(Asset::Texture_ID::hills);
-			state->hills[1].position.x = hill_texture.width;
+			for (size_t i = 0; i < Rules::hill_count; i++) {
+				scenery.spawn({
+					.kind = Entity_Kind::hill,
+					.texture = Asset::Texture_ID::hills,
+					.position = glm::vec2(hill_texture.width * i, bottom_of_view + hill_texture.height / 2),
+					.scroll_scale = Game_Properties::hill_scroll_modifier,
+					.recycle_x = -(float)hill_texture.width,
+					.wrap_distance = (float)hill_texture.width * Rules::hill_count
+				});
+			}
 		}
 
-		// Setup grounds
+		// Setup the initial pipe positions when we start playing
+		{
+			const Asset::Texture pipe_texture = Asset::get_texture(Asset::Texture_ID::pipe);
+			for (size_t pair_i = 0; pair_i < Rules::pipe_pair_count; pair_i++) {
+				Entity_Spawn pipe = {
+					.kind = Entity_Kind::pipe_top,
+					.texture = Asset::Texture_ID::pipe,
+					.position = glm::vec2(Rules::pipe.x_spacing * (pair_i + 1), 0.0f),
+					.scroll_scale = 1.0f,
+					.recycle_x = left_of_view - pipe_texture.width / 2,
+					.wrap_distance = Rules::pipe.x_spacing * Rules::pipe_pair_count
+				};
+				const size_t top_i = scenery.spawn(pipe);
+
+				// Flip bottom pipe
+				pipe.kind = Entity_Kind::pipe_bottom;
+				pipe.scale = glm::vec2(1.0f, -1.0f);
+				scenery.spawn(pipe);
+
+				place_pipe_pair(&scenery, top_i);
+			}
+		}
+
+		// Grounds. Isn't actually recycled at the right of the ground, needed
+		// to give it some more padding to prevent artifact.
 		{
 			const Asset::Texture ground_texture = Asset::get_texture(Asset::Texture_ID::ground);
-			float x = -Game_Properties::view.width / 2 + ground_texture.width / 2;
-			const float y = -Game_Properties::view.height / 2 + ground_texture.height / 2;
-			for (Ground &ground : state->grounds) {
-				ground.position.x = x;
-				ground.position.y = y;
+			for (size_t i = 0; i < Rules::ground_count; i++) {
+				scenery.spawn({
+					.kind = Entity_Kind::ground,
+					.texture = Asset::Texture_ID::ground,
+					.position = glm::vec2(
+						left_of_view + ground_texture.width / 2 + ground_texture.width * i, 
+						bottom_of_view + ground_texture.height / 2
+					),
+					.scroll_scale = 1.0f,
+					.recycle_x = left_of_view - ground_texture.width,
+					.wrap_distance = (float)ground_texture.width * Rules::ground_count
+				});
+			}
+		}
+	}
 
-				x += ground_texture.width;
+	// Rewrites what `setup` copied out of the tunable rules, so a reloaded
+	// profile applies to the scenery already spawned. Pipes already in view
+	// keep their spacing until they wrap.
+	static void apply_tuning(Game_State *state) {
+		Scenery &scenery = state->scenery;
+		for (size_t i = 0; i < scenery.length; i++) {
+			switch (scenery.kinds[i]) {
+				case Entity_Kind::cloud: {
+					scenery.scroll_scales[i] = Rules::cloud.scroll_modifier;
+					scenery.recycle_xs[i] = Rules::cloud.x_min;
+				} break;
+				case Entity_Kind::pipe_top:
+				case Entity_Kind::pipe_bottom: {
+					scenery.wrap_distances[i] = Rules::pipe.x_spacing * Rules::pipe_pair_count;
+				} break;
+				default: break;
 			}
 		}
 	}
 
+	// Has no side effects outside of its arguments. Anything the rest of the
+	// game should act on, such as sounds and saves, is added to `events`.
 	static void update(
 		Game_State *state, 
 		Input *input, 
-		Persistent_Game_State *persistent_state, 
+		const Persistent_Game_State &persistent_state, 
 		Debug_State *debug_state, 
-		Platform *platform,
-		Audio_Player *audio_player,
+		Game_Events *events,
 		float delta
 	) {
-		state->text = {};
+		state->text.clear();
+		events->clear();
 
-		handle_game_reset(state, persistent_state, platform, input);
+		handle_game_reset(state, persistent_state, input, events);
 
 		// Handle first flap
 		if (!state->play_started && input->flap) {
 			state->play_started = true;
 		}
 
-		clouds(state, delta);
-		hills(state, delta);
-		pipe(state, delta);
-		ground(state, delta);
-		bird(state, input, audio_player, delta);
-		score(state, persistent_state, audio_player);
-		detect_collisions(state, audio_player);
+		// Pipes only scroll at a fixed speed, so the bird's path relative to
+		// them this tick is still a straight line.
+		const glm::vec2 bird_start = state->bird.position;
+		const float pipe_shift = is_playing(*state) ? -Rules::scroll_speed * delta : 0.0f;
+
+		scroll_scenery(state, delta);
+		recycle_scenery(state);
+		bird(state, input, events, delta);
+		score(state, persistent_state, events, pipe_shift);
+		detect_collisions(state, events, bird_start, pipe_shift);
 
 		if (debug_state != nullptr) {
 			debug_collision_shapes(*state, debug_state);
 		}
 	}
 
-	static void populate_sprites(Game_State *state, Game_State *previous_state, float alpha) {
-		// Clear the sprites
-		state->sprites = {};
+	// Runs once per tick, the renderer does the per frame interpolation.
+	static void populate_sprites(const Game_State &state, const Game_State &previous_state, Sprites *sprites) {
+		sprites->clear();
 
 		// Sky
 		{
-			Sprite sky = { .texture = Asset::Texture_ID::sky };
-			state->sprites.push(sky);
+			const Entity sky = {};
+			sprites->push(Asset::Texture_ID::sky, sky, sky);
 		}
 
-		// Clouds
-		for (size_t i = 0; i < state->clouds.size(); i++) {
-			const Cloud &cloud = state->clouds[i];
-			const Cloud &previous_cloud = previous_state->clouds[i];
-
-			Asset::Texture_ID cloud_texture_id;
-			switch (cloud.type) {
-				case Cloud::Type::one: {
-					cloud_texture_id = Asset::Texture_ID::cloud1;
-				} break;
-				case Cloud::Type::two: {
-					cloud_texture_id = Asset::Texture_ID::cloud2;
-				} break;
-			}
-
-			const Entity cloud_entity = cloud.lerp(previous_cloud, alpha);
-			Sprite cloud_sprite = { .texture = cloud_texture_id, .transform = cloud_entity.get_transform() };
-			state->sprites.push(cloud_sprite);
-		}
-
-		// Hills
-		for (size_t i = 0; i < state->hills.size(); i++) {
-			const Hill &hill = state->hills[i];
-			const Hill &previous_hill = previous_state->hills[i];
-
-			const Entity hill_entity = hill.lerp(previous_hill, alpha);
-			Sprite hill_sprite = { .texture = Asset::Texture_ID::hills, .transform = hill_entity.get_transform() };
-			state->sprites.push(hill_sprite);
-		}
-
-		// Pipes
-		for (size_t pair_i = 0; pair_i < state->pipe_pairs.size(); pair_i++) {
-			const Pipe_Pair &pair = state->pipe_pairs[pair_i];
-			const Pipe_Pair &previous_pair = previous_state->pipe_pairs[pair_i];
-
-			const Pipe pipes[2] = { pair.top, pair.bottom };
-			const Pipe previous_pipes[2] = { previous_pair.top, previous_pair.bottom };
-			for (size_t pipe_i = 0; pipe_i < 2; pipe_i++) {
-				const Pipe pipe = pipes[pipe_i];
-				const Pipe previous_pipe = previous_pipes[pipe_i];
-
-				const Entity pipe_entity = pipe.lerp(previous_pipe, alpha);
-				Sprite pipe_sprite = { .texture = Asset::Texture_ID::pipe, .transform = pipe_entity.get_transform() };
-				state->sprites.push(pipe_sprite);
-			}
-		}
-
-		// Ground
-		for (size_t i = 0; i < state->grounds.size(); i++) {
-			const Ground &ground = state->grounds[i];
-			const Ground &previous_ground = previous_state->grounds[i];
-
-			const Entity ground_entity = ground.lerp(previous_ground, alpha);
-			Sprite ground_sprite = { .texture = Asset::Texture_ID::ground, .transform = ground_entity.get_transform() };
-			state->sprites.push(ground_sprite);
-		} 
+		sprites->push(state.scenery, previous_state.scenery);
 
 		// Bird
-		{
-			const Entity bird_entity = state->bird.lerp(previous_state->bird, alpha);
-			Sprite bird_sprite = { .texture = Asset::Texture_ID::bird, .transform = bird_entity.get_transform() };
-			state->sprites.push(bird_sprite);
-		}
+		sprites->push(Asset::Texture_ID::bird, state.bird, previous_state.bird);
 	}
 
 private:
@@ -167,42 +177,71 @@ private:
 	}
 
 	static glm::vec2 get_random_cloud_scale(size_t index, size_t length) {
-		const float scale_range = Game_Properties::cloud.scale_max + Game_Properties::cloud.scale_min * -1;
+		const float scale_range = Rules::cloud.scale_max + Rules::cloud.scale_min * -1;
 		const float scale_section = scale_range / length;
-		const float min = scale_section * index + Game_Properties::cloud.scale_min;
+		const float min = scale_section * index + Rules::cloud.scale_min;
 		const float max = min + scale_section;
 		const float scale_result = rand_range(min, max);
 		return glm::vec2(scale_result);
 	}
 
-	static void clouds(Game_State *state, float delta) {
-		for (size_t i = 0; i < state->clouds.size(); i++) {
-			Cloud &cloud = state->clouds[i];
+	// Moves every entity by its own velocity plus its share of the world
+	// scroll.
+	static void scroll_scenery(Game_State *state, float delta) {
+		Scenery &scenery = state->scenery;
+		const float scroll_speed = is_playing(*state) ? Rules::scroll_speed : 0.0f;
+
+		for (size_t i = 0; i < scenery.length; i++) {
+			const glm::vec2 scroll_velocity = glm::vec2(-scroll_speed * scenery.scroll_scales[i], 0.0f);
+			scenery.positions[i] += (scenery.velocities[i] + scroll_velocity) * delta;
+		}
+	}
+
+	// Wraps entities that have gone off to the left back round to the right,
+	// as new entities.
+	static void recycle_scenery(Game_State *state) {
+		Scenery &scenery = state->scenery;
 
-			cloud.position.x -= Game_Properties::cloud.scroll_speed * cloud.speed_scale * delta;
-			if (is_playing(*state)) { 
-				cloud.position.x -= Game_Properties::scroll_speed * Game_Properties::cloud.scroll_modifier * delta;
+		for (size_t i = 0; i < scenery.length; i++) {
+			if (scenery.positions[i].x > scenery.recycle_xs[i]) {
+				continue;
 			}
 
-			// Recycle cloud 
-			if (cloud.position.x <= Game_Properties::cloud.x_min) {
-				cloud.version++;
-				cloud.type = rand() % 2 == 0 ? Cloud::Type::one : Cloud::Type::two;
-				cloud.speed_scale = rand_range(
-					Game_Properties::cloud.speed_scale_min, 
-					Game_Properties::cloud.speed_scale_max
-				),
-				cloud.position = glm::vec2(
-					Game_Properties::cloud.x_max,
-					rand_range(Game_Properties::cloud.y_min, Game_Properties::cloud.y_max)
-				);
-				cloud.scale = get_random_cloud_scale(i, state->clouds.size());
+			scenery.positions[i].x += scenery.wrap_distances[i];
+			scenery.versions[i]++;
+
+			switch (scenery.kinds[i]) {
+				case Entity_Kind::cloud: {
+					respawn_cloud(&scenery, i, Rules::cloud.x_max);
+				} break;
+				case Entity_Kind::pipe_top: {
+					place_pipe_pair(&scenery, i);
+				} break;
+				default: break;
 			}
 		}
 	}
 
+	// Clouds are spawned first, so their index is also their place in the
+	// spread of scales.
+	static void respawn_cloud(Scenery *scenery, size_t i, float x) {
+		const float speed_scale = rand_range(
+			Rules::cloud.speed_scale_min, 
+			Rules::cloud.speed_scale_max
+		);
+
+		scenery->textures[i] = rand() % 2 == 0 ? Asset::Texture_ID::cloud1 : Asset::Texture_ID::cloud2;
+		scenery->velocities[i] = glm::vec2(-Rules::cloud.scroll_speed * speed_scale, 0.0f);
+		scenery->positions[i] = glm::vec2(x, rand_range(Rules::cloud.y_min, Rules::cloud.y_max));
+		scenery->scales[i] = get_random_cloud_scale(i, Rules::cloud_count);
+	}
+
+	static bool is_pipe(Entity_Kind kind) {
+		return kind == Entity_Kind::pipe_top || kind == Entity_Kind::pipe_bottom;
+	}
+
 	static void debug_collision_shapes(const Game_State &state, Debug_State *debug_state) {
-		debug_state->debug_shapes = {};
+		debug_state->debug_shapes.clear();
 
 		if (!debug_state->show_collision_debugger) {
 			return;
@@ -212,90 +251,151 @@ private:
 		const glm::vec4 green = glm::vec4(0.0f, 1.0f, 0.0f, 0.5f);
 		const glm::vec4 blue = glm::vec4(0.0f, 0.0f, 1.0f, 0.5f);
 
+		const Collision_Mask &bird_mask = Asset::bird_collision_mask;
 		Shape bird_collision_shape = {};
-		bird_collision_shape.transform = glm::translate(bird_collision_shape.transform, glm::vec3(state.bird.position, 0.0f));
+		bird_collision_shape.transform = Affine::from(state.bird.position, state.bird.rotation, glm::vec2(1.0f));
 		bird_collision_shape.colour = state.bird.is_colliding ? red : green;
-		bird_collision_shape.type = Shape_Type::circle;
-		bird_collision_shape.circle = { .radius = Game_Properties::bird.collision_radius };
+		bird_collision_shape.type = Shape_Type::rectangle;
+		bird_collision_shape.rectangle = bird_mask.get_size();
 		debug_state->debug_shapes.push(bird_collision_shape);
 
-		for (const Pipe_Pair &pair : state.pipe_pairs) {
-			Shape top_collision_shape = {};
-			top_collision_shape.transform = glm::translate(
-				top_collision_shape.transform, 
-				glm::vec3(pair.top.position.x, pair.top.position.y, 0.0f)
-			);
-			top_collision_shape.colour = blue;
-			top_collision_shape.type = Shape_Type::rectangle;
-			top_collision_shape.rectangle = { 
-				.width = Game_Properties::pipe.collision_rect.width, 
-				.height = Game_Properties::pipe.collision_rect.height, 
-			};
-			debug_state->debug_shapes.push(top_collision_shape);
-
-			Shape bottom_collision_shape = {};
-			bottom_collision_shape.transform = glm::translate(
-				bottom_collision_shape.transform, 
-				glm::vec3(pair.bottom.position.x, pair.bottom.position.y, 0.0f)
-			);
-			bottom_collision_shape.colour = blue;
-			bottom_collision_shape.type = Shape_Type::rectangle;
-			bottom_collision_shape.rectangle = { 
-				.width = Game_Properties::pipe.collision_rect.width, 
-				.height = Game_Properties::pipe.collision_rect.height, 
-			};
-			debug_state->debug_shapes.push(bottom_collision_shape);
+		const Collision_Mask &pipe_mask = Asset::pipe_collision_mask;
+		for (size_t i = 0; i < state.scenery.length; i++) {
+			if (!is_pipe(state.scenery.kinds[i])) {
+				continue;
+			}
+
+			Shape pipe_collision_shape = {};
+			pipe_collision_shape.transform = Affine::from(state.scenery.positions[i], 0.0f, glm::vec2(1.0f));
+			pipe_collision_shape.colour = blue;
+			pipe_collision_shape.type = Shape_Type::rectangle;
+			pipe_collision_shape.rectangle = pipe_mask.get_size();
+			debug_state->debug_shapes.push(pipe_collision_shape);
 		}
 
 		Shape floor_collision_shape = {};
-		floor_collision_shape.transform = glm::translate(glm::mat4(1.0f), Game_Properties::floor_collision.position);
+		floor_collision_shape.transform = Affine::from(glm::vec2(Game_Properties::floor_collision.position), 0.0f, glm::vec2(1.0f));
 		floor_collision_shape.type = Shape_Type::rectangle;
 		floor_collision_shape.rectangle = Game_Properties::floor_collision.size;
 		floor_collision_shape.colour = blue;
 		debug_state->debug_shapes.push(floor_collision_shape);
 	}
 
-	static void detect_collisions(Game_State *state, Audio_Player *audio_player) {
+	// Sweeps the bird along its path this tick so a fast fall or a long tick
+	// can't carry it through a pipe lip or the floor between two samples. The
+	// bird's bounding circle is swept against each obstacle's bounds first, and
+	// only from there are the pixel masks tested, a unit of movement at a time.
+	static void detect_collisions(
+		Game_State *state, 
+		Game_Events *events, 
+		glm::vec2 bird_start, 
+		float pipe_shift
+	) {
 		if (state->bird.is_colliding) {
 			return;
 		}
 
+		// The bird's silhouette as it is drawn this tick.
+		Collision_Mask bird_mask;
+		bird_mask.build_transformed(Asset::bird_collision_mask, state->bird.rotation, state->bird.scale);
+		const float bird_radius = glm::length(glm::vec2(bird_mask.width, bird_mask.height)) / 2;
+
+		const Collision_Mask &pipe_mask = Asset::pipe_collision_mask;
+		const glm::vec2 bird_end = state->bird.position;
 		bool is_colliding = false;
+		float time_of_impact = 1.0f;
 
-		for (const Pipe_Pair &pair : state->pipe_pairs) {
-			for (const Pipe &pipe : { pair.top, pair.bottom }) {
-				const bool is_intersecting = circle_rect_intersection(
-					state->bird.position, 
-					Game_Properties::bird.collision_radius, 
-					pipe.position, 
-					Game_Properties::pipe.collision_rect
-				);
+		const Scenery &scenery = state->scenery;
+		for (size_t i = 0; i < scenery.length; i++) {
+			if (!is_pipe(scenery.kinds[i])) {
+				continue;
+			}
 
-				if (is_intersecting) {
-					is_colliding = true;
-				}
+			// Measured in the pipe's frame, where only the bird moves.
+			const glm::vec2 pipe_position = scenery.positions[i];
+			const bool pipe_is_flipped = scenery.scales[i].y < 0.0f;
+			float pipe_time_of_impact;
+			const bool is_intersecting = sweep_bird(
+				bird_start + glm::vec2(pipe_shift, 0.0f), 
+				bird_end, 
+				bird_radius, 
+				pipe_position, 
+				pipe_mask.get_size(), 
+				[&](glm::vec2 bird_position) {
+					return collision_mask_intersection(bird_mask, bird_position, pipe_mask, pipe_position, pipe_is_flipped);
+				},
+				&pipe_time_of_impact
+			);
+
+			if (is_intersecting) {
+				is_colliding = true;
+				time_of_impact = glm::min(time_of_impact, pipe_time_of_impact);
 			}
 		}
 
-		is_colliding = is_colliding || circle_rect_intersection(
-			state->bird.position, 
-			Game_Properties::bird.collision_radius, 
+		float floor_time_of_impact;
+		const bool is_hitting_floor = sweep_bird(
+			bird_start, 
+			bird_end, 
+			bird_radius, 
 			Game_Properties::floor_collision.position, 
-			Game_Properties::floor_collision.size
+			Game_Properties::floor_collision.size, 
+			[&](glm::vec2 bird_position) {
+				return collision_mask_rect_intersection(
+					bird_mask, 
+					bird_position, 
+					Game_Properties::floor_collision.position, 
+					Game_Properties::floor_collision.size
+				);
+			},
+			&floor_time_of_impact
 		);
 
+		if (is_hitting_floor) {
+			is_colliding = true;
+			time_of_impact = glm::min(time_of_impact, floor_time_of_impact);
+		}
+
 		state->bird.is_colliding = is_colliding;
 		if (is_colliding) {
-			audio_player->hit();
+			events->push({ .type = Game_Event_Type::hit });
+			state->bird.position = glm::mix(bird_start, bird_end, time_of_impact);
 			state->bird.y_velocity = 0.0f;
 		}
 	}
 
+	template<typename Narrow_Phase>
+	static bool sweep_bird(
+		glm::vec2 start, 
+		glm::vec2 end, 
+		float radius, 
+		glm::vec2 bounds, 
+		Size<float> bounds_size, 
+		Narrow_Phase is_overlapping, 
+		float *time_of_impact
+	) {
+		float enter_time;
+		if (!swept_circle_rect_intersection(start, end, radius, bounds, bounds_size, &enter_time)) {
+			return false;
+		}
+
+		const int step_count = (int)ceilf(glm::length(end - start) * (1.0f - enter_time)) + 1;
+		for (int step_i = 0; step_i <= step_count; step_i++) {
+			const float time = enter_time + (1.0f - enter_time) * step_i / step_count;
+			if (is_overlapping(glm::mix(start, end, time))) {
+				*time_of_impact = time;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
 	static void handle_game_reset(
 		Game_State *state, 
-		Persistent_Game_State *persistent_state, 
-		Platform *platform, 
-		Input *input
+		const Persistent_Game_State &persistent_state, 
+		Input *input,
+		Game_Events *events
 	) {
 		if (!state->bird.is_colliding) {
 			return;
@@ -303,9 +403,16 @@ private:
 
 		const bool should_reset = state->bird.position.y <= -Game_Properties::view.height;
 		if (should_reset) {
-			if (state->score > persistent_state->high_score) {
-				persistent_state->high_score = state->score;
-				platform->save_high_score(persistent_state->high_score);
+			events->push({
+				.type = Game_Event_Type::reset,
+				.score = state->score,
+				.is_recorded = Rules::records_high_score
+			});
+
+			if constexpr (Rules::records_high_score) {
+				if (state->score > persistent_state.high_score) {
+					events->push({ .type = Game_Event_Type::new_high_score, .score = state->score });
+				}
 			}
 
 			*state = {};
@@ -314,68 +421,38 @@ private:
 		}
 	}
 
-	static void ground(Game_State *state, float delta) {
-		const Asset::Texture ground_texture = Asset::get_texture(Asset::Texture_ID::ground);
-
-		if (is_playing(*state)) {
-			for (Ground &ground : state->grounds) {
-				ground.position.x -= Game_Properties::scroll_speed * delta;
-
-				// Isn't actually right of ground, needed to give it some more 
-				// padding to prevent artifact.
-				const float right_of_ground = ground.position.x + ground_texture.width;
-				const float left_of_screen = -Game_Properties::view.width / 2;
-				if (right_of_ground <= left_of_screen) {
-					ground.version++;
-					ground.position.x += ground_texture.width * state->grounds.size();
-				}
-			}
-		}
-	}
-
-	static void hills(Game_State *state, float delta) {
-		const Asset::Texture hills_texture = Asset::get_texture(Asset::Texture_ID::hills);
-
-		// Scroll hills
-		for (Hill &hill : state->hills) {
-			hill.position.y = -Game_Properties::view.height / 2 + hills_texture.height / 2;
-			if (is_playing(*state)) {
-				hill.position.x -= Game_Properties::scroll_speed * Game_Properties::hill_scroll_modifier * delta;
-				if (hill.position.x <= -hills_texture.width) {
-					hill.version++;
-					hill.position.x += hills_texture.width * 2;
-				}
-			}
-		}
-	}
-
 	static bool is_playing(const Game_State &state) {
 		return state.play_started && !state.bird.is_colliding;
 	}
 	
-	static void bird(Game_State *state, Input *input, Audio_Player *audio_player, float delta) {
+	static void bird(Game_State *state, Input *input, Game_Events *events, float delta) {
 		const Asset::Texture bird_texture = Asset::get_texture(Asset::Texture_ID::bird);
 
-		// Apply gravity
-		if (state->play_started) {
-			if (input->hovering && state->bird.y_velocity > .0f) {
-				state->bird.y_velocity -= Game_Properties::bird.gravity * Game_Properties::bird.hovering_scale;
-			} else {
-				state->bird.y_velocity -= Game_Properties::bird.gravity;
-			}
-		}
-
 		// Flap 
 		if (input->flap && !state->bird.is_colliding) {
 			if (state->bird.position.y < Game_Properties::view.height / 2) {
-				state->bird.y_velocity = Game_Properties::bird.flap_force;
+				state->bird.y_velocity = Rules::bird.flap_force;
 			}
 			input->flap_handled();
-			audio_player->flap();
+			events->push({ .type = Game_Event_Type::flap });
 		}
 
+		// Apply gravity. Each step is integrated exactly, so the trajectory is 
+		// the same whatever the tick rate.
 		if (state->play_started) {
-			state->bird.position.y += state->bird.y_velocity * delta;
+			float remaining_time = delta;
+
+			// Gravity is weaker while hovering on the way up. The step is split
+			// where the bird reaches the top of its arc.
+			if (input->hovering && state->bird.y_velocity > .0f) {
+				const float hovering_gravity = Rules::bird.gravity * Rules::bird.hovering_scale;
+				const float time_to_apex = state->bird.y_velocity / hovering_gravity;
+				const float hovering_time = glm::min(time_to_apex, remaining_time);
+				apply_ballistic_step(&state->bird, hovering_gravity, hovering_time);
+				remaining_time -= hovering_time;
+			}
+
+			apply_ballistic_step(&state->bird, Rules::bird.gravity, remaining_time);
 		}
 
 		// Apply rotation
@@ -387,44 +464,29 @@ private:
 		}
 	}
 
-	static void pipe(Game_State *state, float delta) {
-		const Asset::Texture pipe_texture = Asset::get_texture(Asset::Texture_ID::pipe);
-
-		for (Pipe_Pair &pair : state->pipe_pairs) {
-			if (is_playing(*state)) {
-				// Update x position
-				pair.shared_x -= Game_Properties::scroll_speed * delta;
-
-				// Reset pipe if it goes off screen
-				const float right_of_pipe = pair.shared_x + pipe_texture.width / 2;
-				const float left_of_view = -(float)Game_Properties::view.width / 2;
-				const bool pipe_is_offscreen = right_of_pipe <= left_of_view;
-				if (pipe_is_offscreen) {
-					setup_pipe(&pair, pair.shared_x + Game_Properties::pipe.x_spacing * 2);
-				}
-			}
-
-			Pipe *pipes[2] = { &pair.top, &pair.bottom };
-			for (Pipe *pipe : pipes) {
-				pipe->position.x = pair.shared_x;
-			}
-		}
+	static void apply_ballistic_step(Bird *bird, float gravity, float time) {
+		bird->position.y += bird->y_velocity * time - 0.5f * gravity * time * time;
+		bird->y_velocity -= gravity * time;
 	}
 
 	static void score(
 		Game_State *state, 
-		Persistent_Game_State *persistent_state, 
-		Audio_Player *audio_player
+		const Persistent_Game_State &persistent_state, 
+		Game_Events *events,
+		float pipe_shift
 	) {
-		int score = persistent_state->high_score;
+		int score = persistent_state.high_score;
 
 		if (state->play_started) {
-			// Update score
-			for (int i = 0; i < state->pipe_pairs.size(); i++) {
-				if (state->pipe_pairs[i].shared_x <= 0 && state->last_scoring_pipe_index != i) {
-					state->last_scoring_pipe_index = i;
+			// Update score. A pipe scores on the tick it crosses the bird, so
+			// each one scores once however close together they are.
+			const Scenery &scenery = state->scenery;
+			for (size_t i = 0; i < scenery.length; i++) {
+				const float x = scenery.positions[i].x;
+				const bool is_scoring_pipe = scenery.kinds[i] == Entity_Kind::pipe_top && x <= 0 && x - pipe_shift > 0;
+				if (is_scoring_pipe) {
 					state->score++;
-					audio_player->score();
+					events->push({ .type = Game_Event_Type::score, .score = state->score });
 				}
 			}
 
@@ -445,21 +507,16 @@ private:
 		state->text.push(score_text);
 	}
 
-	static void setup_pipe(Pipe_Pair *pair, float x) {
-		pair->top.version++;
-		pair->bottom.version++;
-
+	// Picks a new height for the gap. The bottom pipe is always spawned
+	// straight after the top one.
+	static void place_pipe_pair(Scenery *scenery, size_t top_i) {
 		const Asset::Texture pipe_texture = Asset::get_texture(Asset::Texture_ID::pipe);
 		const float y = (
 			(float)rand() / RAND_MAX * 
-			Game_Properties::pipe.y_range * 2 - 
-			Game_Properties::pipe.y_range
+			Rules::pipe.y_range * 2 - 
+			Rules::pipe.y_range
 		);
-		pair->shared_x = x;
-		pair->top.position.y = y + pipe_texture.height / 2 + Game_Properties::pipe.y_spacing / 2;
-		pair->bottom.position.y = y - pipe_texture.height / 2 - Game_Properties::pipe.y_spacing / 2;
-
-		// Flip bottom pipe
-		pair->bottom.scale.y = -1.0f;
+		scenery->positions[top_i].y = y + pipe_texture.height / 2 + Rules::pipe.y_spacing / 2;
+		scenery->positions[top_i + 1].y = y - pipe_texture.height / 2 - Rules::pipe.y_spacing / 2;
 	}
 };
\ No newline at end of file
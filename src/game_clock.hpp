@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#include "game_properties.hpp"
+#include "logger.hpp"
+
+// Fixed step clock for the simulation. Time is accumulated in integer
+// nanoseconds so the tick cadence doesn't drift or alternate between frame
+// lengths the way millisecond ticks do.
+struct Game_Clock {
+	// Most simulation time caught up in a single frame at normal speed before 
+	// the backlog is dropped. Stops a long stall turning into a spiral of ever
+	// longer frames.
+	static constexpr uint64_t max_catch_up_ns = 133333333;
+	static constexpr uint64_t max_catch_up_ticks = max_catch_up_ns / Game_Properties::sim_time_ns > 0
+		? max_catch_up_ns / Game_Properties::sim_time_ns
+		: 1;
+
+	uint64_t previous_time_ns = 0;
+	uint64_t accumulator_ns = 0;
+	float speed = 1.0f;
+
+	uint64_t tick_count = 0;
+	// Ticks run beyond the first in a single frame.
+	uint64_t caught_up_tick_count = 0;
+	// Ticks thrown away because the backlog went over the catch up limit.
+	uint64_t dropped_tick_count = 0;
+
+	void start(uint64_t time_ns) {
+		this->previous_time_ns = time_ns;
+		this->accumulator_ns = 0;
+	}
+
+	// Returns how many ticks should be simulated this frame. `speed` scales
+	// elapsed time for the debug speed controls.
+	uint64_t advance(uint64_t time_ns, float speed = 1.0f) {
+		const uint64_t elapsed_ns = time_ns - this->previous_time_ns;
+		this->previous_time_ns = time_ns;
+		this->speed = speed;
+
+		if (speed == 1.0f) {
+			this->accumulator_ns += elapsed_ns;
+		} else {
+			this->accumulator_ns += (uint64_t)((double)elapsed_ns * speed);
+		}
+
+		uint64_t ticks = this->accumulator_ns / Game_Properties::sim_time_ns;
+		this->accumulator_ns -= ticks * Game_Properties::sim_time_ns;
+
+		// Faster debug speeds legitimately need more ticks per frame.
+		const uint64_t max_ticks = speed > 1.0f ? (uint64_t)(max_catch_up_ticks * speed) : max_catch_up_ticks;
+		if (ticks > max_ticks) {
+			LOG_DEBUG("Dropped %u ticks after a stall.", ticks - max_ticks);
+			this->dropped_tick_count += ticks - max_ticks;
+			ticks = max_ticks;
+		}
+
+		this->tick_count += ticks;
+		if (ticks > 1) {
+			this->caught_up_tick_count += ticks - 1;
+		}
+
+		return ticks;
+	}
+
+	// The real time that the end of a tick from the last `advance` corresponds
+	// to. Used to hand input to the tick it actually happened in.
+	uint64_t get_tick_time_ns(uint64_t tick_index, uint64_t tick_count) const {
+		if (this->speed <= 0.0f) {
+			return this->previous_time_ns;
+		}
+
+		const uint64_t later_tick_count = tick_count - 1 - tick_index;
+		const uint64_t sim_ns_since_tick = this->accumulator_ns + later_tick_count * Game_Properties::sim_time_ns;
+		return this->previous_time_ns - (uint64_t)(sim_ns_since_tick / this->speed);
+	}
+};
\ No newline at end of file
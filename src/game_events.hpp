@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include "array.hpp"
+#include "audio_player.hpp"
+#include "persistent_game_state.hpp"
+#include "platform.hpp"
+
+enum class Game_Event_Type : uint8_t {
+	flap,
+	score,
+	hit,
+	reset,
+	new_high_score
+};
+
+// Something that happened during a tick that the world outside the
+// simulation may want to act on.
+struct Game_Event {
+	Game_Event_Type type;
+
+	// The run's score, for everything but `flap` and `hit`.
+	int score = 0;
+
+	// For `reset`, whether the run goes towards the saved high score.
+	bool is_recorded = false;
+};
+
+// Written by `Game::update` and drained once it returns. Cleared at the start
+// of every tick.
+using Game_Events = Array<Game_Event, 16>;
+
+template<Audio_Backend Audio>
+inline void play_game_events(std::span<const Game_Event> events, Audio *audio_player) {
+	for (const Game_Event &event : events) {
+		switch (event.type) {
+			case Game_Event_Type::flap: audio_player->flap(); break;
+			case Game_Event_Type::score: audio_player->score(); break;
+			case Game_Event_Type::hit: audio_player->hit(); break;
+			default: break;
+		}
+	}
+}
+
+// Records finished runs and queues them to be saved.
+template<Storage_Backend Storage>
+inline void save_game_events(
+	std::span<const Game_Event> events,
+	Persistent_Game_State *persistent_state,
+	Storage *storage
+) {
+	for (const Game_Event &event : events) {
+		if (event.type == Game_Event_Type::reset && event.is_recorded) {
+			persistent_state->record_game(event.score);
+			storage->save(*persistent_state);
+		}
+	}
+}
+
+// Running totals, logged when the game closes.
+struct Game_Telemetry {
+	uint32_t flap_count = 0;
+	uint32_t score_count = 0;
+	uint32_t hit_count = 0;
+	uint32_t run_count = 0;
+	uint32_t new_high_score_count = 0;
+
+	void record(std::span<const Game_Event> events) {
+		for (const Game_Event &event : events) {
+			switch (event.type) {
+				case Game_Event_Type::flap: this->flap_count++; break;
+				case Game_Event_Type::score: this->score_count++; break;
+				case Game_Event_Type::hit: this->hit_count++; break;
+				case Game_Event_Type::reset: this->run_count++; break;
+				case Game_Event_Type::new_high_score: this->new_high_score_count++; break;
+			}
+		}
+	}
+};
+
+// The latest events along with the tick they happened on, oldest first once
+// it has wrapped. Enough to step back through what led up to a moment, or
+// to compare one run against another.
+struct Game_Event_History {
+	static constexpr size_t capacity = 1024;
+
+	struct Entry {
+		uint64_t tick;
+		Game_Event event;
+	};
+
+	Entry entries[capacity];
+	uint64_t total_count = 0;
+
+	void record(uint64_t tick, std::span<const Game_Event> events) {
+		for (const Game_Event &event : events) {
+			this->entries[this->total_count % capacity] = Entry { .tick = tick, .event = event };
+			this->total_count++;
+		}
+	}
+
+	size_t get_length() const {
+		return this->total_count < capacity ? (size_t)this->total_count : capacity;
+	}
+
+	// `index` 0 is the oldest event still kept.
+	const Entry &get(size_t index) const {
+		const uint64_t first = this->total_count - this->get_length();
+		return this->entries[(first + index) % capacity];
+	}
+
+	struct Run_Summary {
+		// The run's first flap and its `reset`.
+		uint64_t start_tick;
+		uint64_t end_tick;
+		// Zero if the bird fell without hitting anything.
+		uint64_t hit_tick;
+		uint32_t flap_count;
+		int score;
+		bool is_new_high_score;
+		// False if the start of the run has already been overwritten.
+		bool is_complete;
+	};
+
+	// Sums up the run that ended with the newest `reset`, walking back to the
+	// reset before it. False if there is no reset.
+	bool get_last_run(Run_Summary *summary) const {
+		size_t reset_i = this->get_length();
+		bool is_new_high_score = false;
+		while (reset_i > 0 && this->get(reset_i - 1).event.type != Game_Event_Type::reset) {
+			is_new_high_score |= this->get(reset_i - 1).event.type == Game_Event_Type::new_high_score;
+			reset_i--;
+		}
+		if (reset_i == 0) {
+			return false;
+		}
+		reset_i--;
+
+		const Entry &reset = this->get(reset_i);
+		*summary = Run_Summary {
+			.start_tick = reset.tick,
+			.end_tick = reset.tick,
+			.hit_tick = 0,
+			.flap_count = 0,
+			.score = reset.event.score,
+			.is_new_high_score = is_new_high_score,
+			// The first run has no reset before it.
+			.is_complete = this->total_count <= capacity
+		};
+
+		for (size_t i = reset_i; i-- > 0;) {
+			const Entry &entry = this->get(i);
+			if (entry.event.type == Game_Event_Type::reset) {
+				summary->is_complete = true;
+				break;
+			}
+
+			if (entry.event.type == Game_Event_Type::flap) {
+				summary->flap_count++;
+				summary->start_tick = entry.tick;
+			} else if (entry.event.type == Game_Event_Type::hit) {
+				summary->hit_tick = entry.tick;
+			}
+		}
+
+		return true;
+	}
+};
\ No newline at end of file
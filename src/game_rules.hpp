@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "game_properties.hpp"
+
+struct Bird_Rules {
+	// Units per second squared.
+	float gravity;
+	float flap_force;
+	float hovering_scale;
+};
+
+struct Pipe_Rules {
+	float y_range;
+	float x_spacing;
+
+	// Height of the gap between the top and bottom pipe.
+	float y_spacing;
+};
+
+struct Cloud_Rules {
+	float x_min;
+	float x_max;
+	float y_min;
+	float y_max;
+	float speed_scale_min;
+	float speed_scale_max;
+	float scale_min;
+	float scale_max;
+	float scroll_speed;
+	float scroll_modifier;
+};
+
+// Every rule that can change without a rebuild, see `tuning.hpp`. Counts stay
+// compile time only, as they size the scenery.
+struct Tuning {
+	Bird_Rules bird;
+	Pipe_Rules pipe;
+	Cloud_Rules cloud;
+	float scroll_speed;
+};
+
+// Rules are types rather than values, so `Game` is compiled once per variant
+// with every rule folded in as a constant. A variant derives from another and
+// redeclares only what it changes.
+struct Classic_Rules {
+	static constexpr Bird_Rules bird = {
+		.gravity = 600.f,
+		.flap_force = 200.f,
+		.hovering_scale = 0.5f
+	};
+
+	static constexpr Pipe_Rules pipe = {
+		.y_range = (float)Game_Properties::view.height * 0.2f,
+		.x_spacing = (float)Game_Properties::view.width,
+		.y_spacing = (float)Game_Properties::view.height * 0.22f
+	};
+
+	static constexpr Cloud_Rules cloud = {
+		.x_min = -(float)Game_Properties::view.width,
+		.x_max = (float)Game_Properties::view.width,
+		.y_min = 64.0f,
+		.y_max = (float)Game_Properties::view.height / 2,
+		.speed_scale_min = 0.5f,
+		.speed_scale_max = 1.0f,
+		.scale_min = 0.8f,
+		.scale_max = 1.5f,
+		.scroll_speed = 1.0f,
+		.scroll_modifier = .03f
+	};
+
+	static constexpr float scroll_speed = 100.f;
+
+	static constexpr size_t cloud_count = 5;
+	static constexpr size_t pipe_pair_count = 2;
+	static constexpr size_t hill_count = 2;
+	static constexpr size_t ground_count = 9;
+
+	// Whether finished runs go towards the saved high score.
+	static constexpr bool records_high_score = true;
+};
+
+// Faster, with a tighter gap and pipes closer together.
+struct Hard_Rules : Classic_Rules {
+	static constexpr Bird_Rules bird = {
+		.gravity = 750.f,
+		.flap_force = 230.f,
+		.hovering_scale = 0.5f
+	};
+
+	static constexpr Pipe_Rules pipe = {
+		.y_range = (float)Game_Properties::view.height * 0.25f,
+		.x_spacing = (float)Game_Properties::view.width * 0.75f,
+		.y_spacing = (float)Game_Properties::view.height * 0.18f
+	};
+
+	static constexpr size_t pipe_pair_count = 3;
+	static constexpr float scroll_speed = 140.f;
+};
+
+// Slow and forgiving, for learning the timing.
+struct Training_Rules : Classic_Rules {
+	static constexpr Bird_Rules bird = {
+		.gravity = 450.f,
+		.flap_force = 170.f,
+		.hovering_scale = 0.4f
+	};
+
+	static constexpr Pipe_Rules pipe = {
+		.y_range = (float)Game_Properties::view.height * 0.1f,
+		.x_spacing = (float)Game_Properties::view.width * 1.25f,
+		.y_spacing = (float)Game_Properties::view.height * 0.32f
+	};
+
+	static constexpr float scroll_speed = 70.f;
+	static constexpr bool records_high_score = false;
+};
+
+template<typename Rules>
+constexpr Tuning get_tuning() {
+	return Tuning {
+		.bird = Rules::bird,
+		.pipe = Rules::pipe,
+		.cloud = Rules::cloud,
+		.scroll_speed = Rules::scroll_speed
+	};
+}
+
+// Plays like classic, but reads the tunable rules from `tuning` at run time.
+// Once the simulation starts only its thread may write to `tuning`.
+struct Tuned_Rules : Classic_Rules {
+	static inline Tuning tuning = get_tuning<Classic_Rules>();
+
+	static constexpr const Bird_Rules &bird = tuning.bird;
+	static constexpr const Pipe_Rules &pipe = tuning.pipe;
+	static constexpr const Cloud_Rules &cloud = tuning.cloud;
+	static constexpr const float &scroll_speed = tuning.scroll_speed;
+};
+
+// Picks the rules at startup. Everything past the choice runs the variant's
+// own specialised code.
+enum class Game_Variant : uint8_t {
+	classic,
+	hard,
+	training,
+	tuned
+};
+
+inline bool parse_game_variant(const char *name, Game_Variant *variant) {
+	const struct {
+		const char *name;
+		Game_Variant variant;
+	} variants[] = {
+		{ "classic", Game_Variant::classic },
+		{ "hard", Game_Variant::hard },
+		{ "training", Game_Variant::training },
+		{ "tuned", Game_Variant::tuned }
+	};
+
+	for (const auto &entry : variants) {
+		if (strcmp(name, entry.name) == 0) {
+			*variant = entry.variant;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Calls `callback` with a value of the rules type for `variant`, for example
+// `visit_game_rules(variant, [&](auto rules) { Game<decltype(rules)>::setup(state); })`.
+template<typename Callback>
+inline void visit_game_rules(Game_Variant variant, Callback callback) {
+	switch (variant) {
+		case Game_Variant::classic: callback(Classic_Rules {}); break;
+		case Game_Variant::hard: callback(Hard_Rules {}); break;
+		case Game_Variant::training: callback(Training_Rules {}); break;
+		case Game_Variant::tuned: callback(Tuned_Rules {}); break;
+	}
+}
\ No newline at end of file
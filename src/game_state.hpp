@@ -1,17 +1,16 @@
 #pragma once
 
+#include <cassert>
+#include <cstdint>
+
 #include <glm/glm.hpp>
 
 #include "assets.hpp"
 #include "array.hpp"
+#include "entity_store.hpp"
 #include "game_properties.hpp"
 #include "size.hpp"
 
-struct Sprite {
-	Asset::Texture_ID texture;
-	glm::mat4 transform = glm::mat4(1.f);
-};
-
 struct Entity {
 	// Version ID to keep track if it's the same entity as before. It is commonly
 	// changed when recycling the entity when it leaves the view.
@@ -20,27 +19,83 @@ struct Entity {
 	glm::vec2 position = glm::vec2(0.0f);
 	float rotation = 0.0f;
 	glm::vec2 scale = glm::vec2(1.0f);
+};
+
+// Uploaded as is, half the size of the 4x4 matrix a sprite used to carry.
+// Scale is only taken from the current tick, since nothing rescales an entity
+// without also recycling it.
+struct Sprite_Instance {
+	glm::vec2 previous_position;
+	glm::vec2 current_position;
+	float previous_rotation;
+	float current_rotation;
+
+	// With the texture size folded in, so the shader only needs a unit quad.
+	glm::vec2 scale;
+};
+
+static_assert(sizeof(Sprite_Instance) == 32);
+
+// Everything drawn from the textures, built once per tick. The vertex shader
+// blends each sprite from its previous to its current pose every frame.
+struct Sprites {
+	static constexpr size_t capacity = 256;
+
+	size_t length = 0;
+	Asset::Texture_ID textures[capacity];
+	Sprite_Instance instances[capacity];
+
+	void clear() {
+		this->length = 0;
+	}
 
-	// Used to interpolate entities from the previous state only if they are the
-	// same version.
-	Entity lerp(const Entity &from, float alpha) const {
-		if (this->version == from.version) {
-			return Entity {
-				.position = glm::mix(from.position, this->position, alpha),
-				.rotation = glm::mix(from.rotation, this->rotation, alpha),
-				.scale = glm::mix(from.scale, this->scale, alpha),
+	// The previous pose is only used if it is the same version of the entity,
+	// otherwise it would be blended in from wherever it was recycled.
+	void push(Asset::Texture_ID texture, const Entity &entity, const Entity &previous_entity) {
+		assert(this->length != capacity);
+		const size_t i = this->length++;
+		const Entity &from = entity.version == previous_entity.version ? previous_entity : entity;
+
+		this->textures[i] = texture;
+		this->instances[i] = Sprite_Instance {
+			.previous_position = from.position,
+			.current_position = entity.position,
+			.previous_rotation = from.rotation,
+			.current_rotation = entity.rotation,
+			.scale = entity.scale * get_texture_size(texture)
+		};
+	}
+
+	// Appends every entity in the store, one component stream at a time.
+	template<size_t Capacity>
+	void push(const Entity_Store<Capacity> &entities, const Entity_Store<Capacity> &previous_entities) {
+		assert(this->length + entities.length <= capacity);
+		const size_t first = this->length;
+		const size_t count = entities.length;
+
+		for (size_t i = 0; i < count; i++) {
+			this->textures[first + i] = entities.textures[i];
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			const bool is_same = i < previous_entities.length && entities.versions[i] == previous_entities.versions[i];
+			const Entity_Store<Capacity> &from = is_same ? previous_entities : entities;
+			this->instances[first + i] = Sprite_Instance {
+				.previous_position = from.positions[i],
+				.current_position = entities.positions[i],
+				.previous_rotation = from.rotations[i],
+				.current_rotation = entities.rotations[i],
+				.scale = entities.scales[i] * get_texture_size(entities.textures[i])
 			};
 		}
 
-		return *this;
+		this->length += count;
 	}
 
-	glm::mat4 get_transform() const {
-		glm::mat4 transform = glm::identity<glm::mat4>();
-		transform = glm::translate(transform, glm::vec3(this->position.x, this->position.y, 0.0f));
-		transform = glm::rotate(transform, this->rotation, glm::vec3(0.0f, 0.0f, 1.0f));
-		transform = glm::scale(transform, glm::vec3(this->scale.x, this->scale.y, 1.0f));
-		return transform;
+private:
+	static glm::vec2 get_texture_size(Asset::Texture_ID texture) {
+		const Asset::Texture texture_data = Asset::get_texture(texture);
+		return glm::vec2(texture_data.width, texture_data.height);
 	}
 };
 
@@ -49,42 +104,28 @@ struct Bird : Entity {
 	bool is_colliding = false;
 };
 
-struct Pipe : Entity {};
-
-struct Pipe_Pair {
-	float shared_x = 0.0f;
-	Pipe top, bottom;
+enum class Text_Alignment : uint8_t {
+	centre,
+	left
 };
 
+// `position` is the middle of the line's left edge when aligned left.
 struct Text : Entity {
 	glm::vec4 colour;
+	Text_Alignment alignment = Text_Alignment::centre;
 	char text[128];
 };
 
-struct Cloud : Entity {
-	enum class Type {
-		one, two
-	};
-
-	float speed_scale = 1.0f;
-	Type type;
-};
-
-struct Hill : Entity {};
-
-struct Ground : Entity {};
+using Scenery = Entity_Store<64>;
 
 struct Game_State {
 	bool play_started = false;
 	int score = 0;
-	int last_scoring_pipe_index = -1;
 
 	Bird bird;
-	std::array<Cloud, 5> clouds = {};
-	std::array<Hill, 2> hills;
-	std::array<Pipe_Pair, 2> pipe_pairs = {};
-	std::array<Ground, 9> grounds;
 
-	Array<Sprite, 256> sprites;
+	// Clouds, hills, pipes and ground, see `Game::setup`.
+	Scenery scenery;
+
 	Array<Text, 2> text;
 };
\ No newline at end of file
@@ -1,34 +1,47 @@
 #pragma once
 
-#include <stdarg.h>
+#include <cstddef>
+#include <cstring>
+#include <span>
 #include <string>
 
-#include <gl/glew.h>
+#include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
+#include "affine.hpp"
 #include "application.hpp"
+#include "arena.hpp"
 #include "array.hpp"
+#include "asset_loader.hpp"
 #include "assets.hpp"
 #include "game_properties.hpp"
 #include "game_state.hpp"
-#include "platform.hpp"
+#include "logger.hpp"
+#include "native_platform.hpp"
+#include "profiler.hpp"
 #include "debug_state.hpp"
+#include "performance_overlay.hpp"
 
 struct Basic_Shader_Program {
 	GLuint id;
 	struct {
 		GLint view_projection;
-		GLint transform;
+		GLint alpha;
 	} uniform_location;
 };
 
+// A run of consecutive sprites sharing a texture, drawn with one instanced
+// call.
+struct Sprite_Batch {
+	Asset::Texture_ID texture;
+	GLint first;
+	GLsizei count;
+};
+
 struct Shape_Shader_Program {
 	GLuint id;
 	struct {
@@ -70,15 +83,41 @@ public:
 	GLuint generic_vao;
 	GLuint text_vao;
 
+	// Sprites are instanced from the generic quad. The buffer holds every
+	// previous transform followed by every current one.
+	GLuint sprite_vao;
+	GLuint sprite_vbo;
+	Array<Sprite_Batch, 256> sprite_batches;
+
+	// Made by the last call to `render`, and the time it spent on the
+	// performance overlay. Both leave the overlay out, so it doesn't measure
+	// itself.
+	uint32_t draw_call_count = 0;
+	uint64_t overlay_time_ns = 0;
+
+	// The scene is always rasterised at the native view resolution and then
+	// upscaled to the window with a single blit.
+	GLuint view_framebuffer;
+	GLuint view_texture;
+
 private:
-	Platform &platform;
+	Native_Platform &platform;
 	Application &application;
 	Size<int> cached_window_size;
 
+	// Scratch memory that only lasts until the end of the frame.
+	Arena &frame_arena;
+
+	struct {
+		GLint x, y;
+		GLint width, height;
+	} blit_rect = {};
+
 public:
-	GL_Renderer(Application &application, Platform &platform) : 
+	GL_Renderer(Application &application, Native_Platform &platform, Arena &frame_arena) : 
 		application{application}, 
-		platform{platform} {}
+		platform{platform},
+		frame_arena{frame_arena} {}
 
 	bool init(GLDEBUGPROC debug_message_handle) {
 		// Global settings
@@ -90,7 +129,10 @@ public:
 
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-		this->setup_shaders();
+		const bool shaders_loaded_successfully = this->setup_shaders();
+		if (!shaders_loaded_successfully) {
+			return false;
+		}
 		this->setup_view_projection();
 
 		// Generate all texture indices
@@ -105,6 +147,11 @@ public:
 			return false;
 		}
 
+		const bool view_framebuffer_created = this->setup_view_framebuffer();
+		if (!view_framebuffer_created) {
+			return false;
+		}
+
 		// Create generic vertex array object
 		glGenVertexArrays(1, &this->generic_vao);
 		glBindVertexArray(this->generic_vao);
@@ -131,7 +178,25 @@ public:
 		glEnableVertexAttribArray(1);
 		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
 
-		// Create generic vertex array object
+		// Create sprite vertex array object, the same quad plus per instance poses.
+		glGenVertexArrays(1, &this->sprite_vao);
+		glBindVertexArray(this->sprite_vao);
+
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+
+		glGenBuffers(1, &this->sprite_vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, this->sprite_vbo);
+		glBufferData(GL_ARRAY_BUFFER, Sprites::capacity * sizeof(Sprite_Instance), nullptr, GL_STREAM_DRAW);
+		for (GLuint attribute = 2; attribute <= 6; attribute++) {
+			glEnableVertexAttribArray(attribute);
+			glVertexAttribDivisor(attribute, 1);
+		}
+
+		// Create text vertex array object
 		glGenVertexArrays(1, &this->text_vao);
 		glBindVertexArray(this->text_vao);
 
@@ -157,137 +222,197 @@ public:
 		return true;
 	}
 
-	void render(const Game_State &state, Debug_State *debug_state) {
-		this->set_viewport();
+	// Called only when a new tick is published.
+	void upload_sprites(const Sprites &sprites) {
+		glBindBuffer(GL_ARRAY_BUFFER, this->sprite_vbo);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, sprites.length * sizeof(Sprite_Instance), sprites.instances);
+
+		this->sprite_batches.clear();
+		for (size_t i = 0; i < sprites.length; i++) {
+			const Asset::Texture_ID texture = sprites.textures[i];
+			if (this->sprite_batches.length > 0) {
+				Sprite_Batch &batch = this->sprite_batches[this->sprite_batches.length - 1];
+				if (batch.texture == texture) {
+					batch.count++;
+					continue;
+				}
+			}
+
+			this->sprite_batches.push({ .texture = texture, .first = (GLint)i, .count = 1 });
+		}
+	}
+
+	// `alpha` blends each sprite from its previous to its current pose.
+	void render(
+		const Game_State &state,
+		float alpha,
+		const Debug_Shapes *debug_shapes,
+		const Performance_Overlay *performance_overlay
+	) {
+		this->draw_call_count = 0;
 
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		glBindFramebuffer(GL_FRAMEBUFFER, this->view_framebuffer);
+		glViewport(0, 0, Game_Properties::view.width, Game_Properties::view.height);
 
-		glm::mat4 identity = glm::identity<glm::mat4>();
+		glClear(GL_COLOR_BUFFER_BIT);
 
 		// Basic renderer
 		glUseProgram(this->basic_shader_program.id);
-		glBindVertexArray(this->generic_vao);
-		Asset::Texture_ID cache_texture_id = Asset::Texture_ID::none;
-		for (const Sprite &sprite : state.sprites) {
-			const Asset::Texture &texture = Asset::get_texture(sprite.texture);
+		glUniform1f(this->basic_shader_program.uniform_location.alpha, alpha);
+		glBindVertexArray(this->sprite_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, this->sprite_vbo);
+		for (const Sprite_Batch &batch : this->sprite_batches) {
+			glBindTexture(GL_TEXTURE_2D, this->texture_indices[(size_t)batch.texture]);
+
+			this->set_sprite_attributes(batch.first);
+			glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, batch.count);
+			this->draw_call_count++;
+		}
 
-			if (sprite.texture != cache_texture_id) {
-				glBindTexture(GL_TEXTURE_2D, this->texture_indices[(size_t)sprite.texture]);
-				cache_texture_id = sprite.texture;
-			}
+		this->render_text(state.text.view());
 
-			const glm::vec3 texture_size = glm::vec3(texture.width, texture.height, 1.0f);
-			const glm::mat4 scale_transform = glm::scale(identity, texture_size);
-			const glm::mat4 transform = sprite.transform * scale_transform;
-			glUniformMatrix4fv(this->basic_shader_program.uniform_location.transform, 1, GL_FALSE, &transform[0][0]);
+		if (debug_shapes != nullptr) {
+			this->render_shapes(debug_shapes->view());
+		}
 
-			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		this->overlay_time_ns = 0;
+		if (performance_overlay != nullptr) {
+			const uint32_t scene_draw_call_count = this->draw_call_count;
+			const uint64_t overlay_start_ns = this->platform.get_monotonic_time_ns();
+			this->render_shapes(performance_overlay->shapes.view());
+			this->render_text(performance_overlay->text.view());
+			this->overlay_time_ns = this->platform.get_monotonic_time_ns() - overlay_start_ns;
+			this->draw_call_count = scene_draw_call_count;
 		}
 
+		this->present();
+	}
+
+private:
+	void render_text(std::span<const Text> texts) {
+		glUseProgram(this->text_shader_program.id);
+		glBindVertexArray(this->text_vao);
+
 		// Fetch all font characters and calculate the total width.
-		for (const Text &text : state.text) {
+		for (const Text &text : texts) {
 			float total_width = 0;
-			Array<const Font_Face_Character *, 128> characters;
-			{
-				int i = 0;
-				char c = text.text[i];
-				while (c != '\0') {
-					const Font_Face_Character *character = &this->font_face.characters[(size_t)c];
-					characters.push(character);
-					total_width += (character->advance_x >> 6) * text.scale.x;
-					c = text.text[++i];
-				}
+			const size_t character_count = strlen(text.text);
+			const Font_Face_Character **characters = this->frame_arena.push_array<const Font_Face_Character *>(character_count);
+			for (size_t i = 0; i < character_count; i++) {
+				const Font_Face_Character *character = &this->font_face.characters[(size_t)text.text[i]];
+				characters[i] = character;
+				total_width += (character->advance_x >> 6) * text.scale.x;
 			}
 
-			// Modify the x starting position so we are the origin point of all text is at the center.
-			float x = text.position.x - total_width / 2;
+			// Centred text starts half its width left of its position.
+			float x = text.alignment == Text_Alignment::centre ? text.position.x - total_width / 2 : text.position.x;
 			float y = text.position.y;
 
-			glUseProgram(this->text_shader_program.id);
-			glBindVertexArray(this->text_vao);
-			for (const Font_Face_Character *character : characters) {
+			for (size_t i = 0; i < character_count; i++) {
+				const Font_Face_Character *character = characters[i];
 				glBindTexture(GL_TEXTURE_2D, character->texture_id);
 
 				glUniform4fv(this->text_shader_program.uniform_location.text_colour, 1, &text.colour[0]);
 
 				const float y_offset = this->font_face.height / 2 * text.scale.y;
-				const glm::vec3 position = glm::vec3(
+				const glm::vec2 position = glm::vec2(
 					x + character->left * text.scale.x, 
-					y - y_offset - (character->height - character->top) * text.scale.y, 
-					0.0f
+					y - y_offset - (character->height - character->top) * text.scale.y
 				);
-				glm::mat4 transform = glm::translate(identity, position);
-
-				const glm::vec3 size = glm::vec3(character->width * text.scale.x, character->height * text.scale.y, 1.0f);
-				transform = glm::scale(transform, size);
-				glUniformMatrix4fv(this->text_shader_program.uniform_location.transform, 1, GL_FALSE, &transform[0][0]);
+				const glm::vec2 size = glm::vec2(character->width * text.scale.x, character->height * text.scale.y);
+				const Affine transform = Affine::from(position, 0.0f, size);
+				glUniformMatrix3x2fv(this->text_shader_program.uniform_location.transform, 1, GL_FALSE, transform.data());
 
 				x += (character->advance_x >> 6) * text.scale.x;
 
 				glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+				this->draw_call_count++;
 			}
 		}
+	}
 
-		if (debug_state != nullptr) {
-			glUseProgram(this->shape_shader_program.id);
-			glBindVertexArray(this->generic_vao);
-			for (const Shape &debug_shape : debug_state->debug_shapes) {
-				const glm::vec4 colour = glm::vec4(1.0f, 1.0f, 1.0f, 0.5f);
-
-				glm::mat4 scale_transform;
-				if (debug_shape.type == Shape_Type::rectangle) {
-					scale_transform = glm::scale(identity, glm::vec3(debug_shape.rectangle.width, debug_shape.rectangle.height, 1.0f));
-				} else if (debug_shape.type == Shape_Type::circle) {
-					const float size = debug_shape.circle.radius * 2;
-					scale_transform = glm::scale(identity, glm::vec3(size, size, 1.0f));
-				}
+	void render_shapes(std::span<const Shape> shapes) {
+		glUseProgram(this->shape_shader_program.id);
+		glBindVertexArray(this->generic_vao);
+		for (const Shape &shape : shapes) {
+			glm::vec2 size = glm::vec2(1.0f);
+			if (shape.type == Shape_Type::rectangle) {
+				size = glm::vec2(shape.rectangle.width, shape.rectangle.height);
+			} else if (shape.type == Shape_Type::circle) {
+				size = glm::vec2(shape.circle.radius * 2);
+			}
 
-				const glm::mat4 transform = debug_shape.transform * scale_transform;
+			const Affine transform = shape.transform.scaled(size);
 
-				glUniform4fv(this->shape_shader_program.uniform_location.colour, 1, &debug_shape.colour[0]);
-				glUniformMatrix4fv(this->shape_shader_program.uniform_location.transform, 1, GL_FALSE, &transform[0][0]);
-				glUniform1i(this->shape_shader_program.uniform_location.shape_type, (GLint)debug_shape.type);
-				glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-			}
+			glUniform4fv(this->shape_shader_program.uniform_location.colour, 1, &shape.colour[0]);
+			glUniformMatrix3x2fv(this->shape_shader_program.uniform_location.transform, 1, GL_FALSE, transform.data());
+			glUniform1i(this->shape_shader_program.uniform_location.shape_type, (GLint)shape.type);
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+			this->draw_call_count++;
 		}
 	}
 
-private:
+	// GL 3.3 has no base instance, so the instance attributes are pointed at
+	// the first sprite of each batch instead.
+	void set_sprite_attributes(GLint first) {
+		const size_t base = first * sizeof(Sprite_Instance);
+		const GLsizei stride = sizeof(Sprite_Instance);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(Sprite_Instance, previous_position)));
+		glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(Sprite_Instance, current_position)));
+		glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(Sprite_Instance, previous_rotation)));
+		glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(Sprite_Instance, current_rotation)));
+		glVertexAttribPointer(6, 2, GL_FLOAT, GL_FALSE, stride, (void*)(base + offsetof(Sprite_Instance, scale)));
+	}
+
 	GLint get_uniform_location(GLuint program_id, const char *uniform_name, const char *shader_name) {
 		const GLint location = glGetUniformLocation(program_id, uniform_name);
 		if (location == -1) {
-			this->log("Could not retrieve uniform location (%s) from shader (%s)", uniform_name, shader_name);
+			LOG_ERROR("Could not retrieve uniform location (%s) from shader (%s)", uniform_name, shader_name);
 		}
 		return location;
 	}
 
-	void setup_shaders() {
-		this->setup_shader(&this->basic_shader_program.id, Asset::Shader_ID::basic, "Basic");
+	bool setup_shaders() {
+		PROFILE_ZONE("Load shaders");
+		if (!this->setup_shader(&this->basic_shader_program.id, Asset::Shader_ID::basic, "Basic")) {
+			return false;
+		}
 		this->basic_shader_program.uniform_location.view_projection = this->get_uniform_location(this->basic_shader_program.id, "view_projection", "Basic");
-		this->basic_shader_program.uniform_location.transform = this->get_uniform_location(this->basic_shader_program.id, "transform", "Basic");
+		this->basic_shader_program.uniform_location.alpha = this->get_uniform_location(this->basic_shader_program.id, "alpha", "Basic");
 
-		this->setup_shader(&this->shape_shader_program.id, Asset::Shader_ID::shape, "Shape");
+		if (!this->setup_shader(&this->shape_shader_program.id, Asset::Shader_ID::shape, "Shape")) {
+			return false;
+		}
 		this->shape_shader_program.uniform_location.view_projection = this->get_uniform_location(this->shape_shader_program.id, "view_projection", "Shape");
 		this->shape_shader_program.uniform_location.transform = this->get_uniform_location(this->shape_shader_program.id, "transform", "Shape");
 		this->shape_shader_program.uniform_location.colour = this->get_uniform_location(this->shape_shader_program.id, "colour", "Shape");
 		this->shape_shader_program.uniform_location.shape_type = this->get_uniform_location(this->shape_shader_program.id, "shape_type", "Shape");
 
-		this->setup_shader(&this->text_shader_program.id, Asset::Shader_ID::text, "Text");
+		if (!this->setup_shader(&this->text_shader_program.id, Asset::Shader_ID::text, "Text")) {
+			return false;
+		}
 		this->text_shader_program.uniform_location.view_projection = this->get_uniform_location(this->text_shader_program.id, "view_projection", "Text");
 		this->text_shader_program.uniform_location.transform = this->get_uniform_location(this->text_shader_program.id, "transform", "Text");
 		this->text_shader_program.uniform_location.text_colour = this->get_uniform_location(this->text_shader_program.id, "text_colour", "Text");
+
+		return true;
 	}
 
-	void setup_shader(GLuint *program_id, Asset::Shader_ID shader_id, const char *name) {
+	bool setup_shader(GLuint *program_id, Asset::Shader_ID shader_id, const char *name) {
 		const char *shader_path = Asset::get_shader(shader_id);
 		const std::string file_path = this->platform.get_asset_path(shader_path);
 
 		Platform_File *vertex_shader_file;
 		const std::string vertex_shader_path = file_path + ".vert";
 		this->platform.load_file(vertex_shader_path.c_str(), &vertex_shader_file);
+		if (vertex_shader_file == nullptr) {
+			LOG_ERROR("Could not read vertex shader (%s).", vertex_shader_path.c_str());
+			return false;
+		}
 
 		GLuint vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-		glShaderSource(vertex_shader, 1, &vertex_shader_file->contents, NULL);
+		const GLint vertex_shader_length = (GLint)vertex_shader_file->content_size;
+		glShaderSource(vertex_shader, 1, &vertex_shader_file->contents, &vertex_shader_length);
 		glCompileShader(vertex_shader);
 		this->log_shader_compile_error(vertex_shader, name, "Vertex");
 		this->platform.close_file(&vertex_shader_file);
@@ -295,9 +420,15 @@ private:
 		Platform_File *fragment_shader_file;
 		const std::string frag_shader_path = file_path + ".frag";
 		this->platform.load_file(frag_shader_path.c_str(), &fragment_shader_file);
+		if (fragment_shader_file == nullptr) {
+			LOG_ERROR("Could not read fragment shader (%s).", frag_shader_path.c_str());
+			glDeleteShader(vertex_shader);
+			return false;
+		}
 
 		GLuint fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-		glShaderSource(fragment_shader, 1, &fragment_shader_file->contents, NULL);
+		const GLint fragment_shader_length = (GLint)fragment_shader_file->content_size;
+		glShaderSource(fragment_shader, 1, &fragment_shader_file->contents, &fragment_shader_length);
 		glCompileShader(fragment_shader);
 		this->log_shader_compile_error(fragment_shader, name, "Fragment");
 		this->platform.close_file(&fragment_shader_file);
@@ -313,6 +444,8 @@ private:
 
 		glDeleteShader(vertex_shader);
 		glDeleteShader(fragment_shader);
+
+		return true;
 	}
 
 	void setup_view_projection() {
@@ -332,42 +465,30 @@ private:
 		glUniformMatrix4fv(this->text_shader_program.uniform_location.view_projection, 1, GL_FALSE, &view_projection[0][0]);
 	}
 
+	// Only uploads, sizes and collision masks come from
+	// `Asset_Loader::load_simulation_assets`.
 	bool load_all_textures() {
-		std::string file_path = "";
-		for (int i = 0; i < Asset::texture_data.size(); i++) {
-			Asset::Texture &texture = Asset::texture_data[i];
-			Asset::Texture_ID texture_id = static_cast<Asset::Texture_ID>(i);
-
-			file_path = this->platform.get_asset_path(texture.location);
-
-			// Don't need to do anything with `channels_in_texture` as stbi_load
-			// will automatically fill in the extra channels for me.
-			int channels_in_texture;
-			unsigned char *data = stbi_load(
-				file_path.c_str(), 
-				&texture.width, 
-				&texture.height, 
-				&channels_in_texture, 
-				4
-			);
+		PROFILE_ZONE("Load textures");
+		for (size_t i = 0; i < Asset::texture_data.size(); i++) {
+			const Asset::Texture_ID texture_id = static_cast<Asset::Texture_ID>(i);
 
+			int width, height;
+			unsigned char *data = Asset_Loader::decode_texture(this->platform, texture_id, &width, &height);
 			if (data == nullptr) {
-				this->log(stbi_failure_reason());
 				return false;
 			}
 
-			this->load_texture(data, texture_id, texture);
-
+			this->load_texture(data, texture_id, width, height);
 			stbi_image_free(data);
 		}
 
 		return true;
 	}
 
-	void load_texture(unsigned char *data, Asset::Texture_ID asset_id, const Asset::Texture &texture) {
+	void load_texture(unsigned char *data, Asset::Texture_ID asset_id, int width, int height) {
 		const size_t asset_index = static_cast<size_t>(asset_id);
 		glBindTexture(GL_TEXTURE_2D, this->texture_indices[asset_index]);
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texture.width, texture.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -375,26 +496,37 @@ private:
 	}
 
 	bool load_font() {
+		PROFILE_ZONE("Load font");
 		std::string file_path = this->platform.get_asset_path(Asset::font_location);
 
 		FT_Library freetype;
 		if (FT_Init_FreeType(&freetype) != 0) {
-			this->log("Could not init FreeType.");
+			LOG_ERROR("Could not init FreeType.");
+			return false;
+		}
+
+		// FreeType reads from the file contents until the face is done with, so
+		// the file stays open until then.
+		Platform_File *file;
+		this->platform.load_file(file_path.c_str(), &file);
+		if (file == nullptr) {
 			return false;
 		}
 
 		FT_Face face;
-		if (FT_New_Face(freetype, file_path.c_str(), 0, &face) != 0) {
-			this->log("Could not load font: %s", file_path);
+		if (FT_New_Memory_Face(freetype, (const FT_Byte *)file->contents, (FT_Long)file->content_size, 0, &face) != 0) {
+			LOG_ERROR("Could not load font: %s", file_path.c_str());
+			this->platform.close_file(&file);
 			return false;
 		}
 
-		FT_Set_Pixel_Sizes(face, 0, 16);
+		FT_Set_Pixel_Sizes(face, 0, Game_Properties::font_size);
 		this->font_face.height = face->size->metrics.height >> 6;
 
 		for (unsigned char i = 0; i < 128; i++) {
 			if (FT_Load_Char(face, i, FT_LOAD_RENDER) != 0) {
-				this->log("Could not load glyph: %c, in font: %s", i, file_path);
+				LOG_ERROR("Could not load glyph: %c, in font: %s", i, file_path.c_str());
+				this->platform.close_file(&file);
 				return false;
 			}
 
@@ -411,6 +543,7 @@ private:
 
 		FT_Done_Face(face);
 		FT_Done_FreeType(freetype);
+		this->platform.close_file(&file);
 
 		return true;
 	}
@@ -434,48 +567,95 @@ private:
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	}
 
-	void set_viewport() {
+	bool setup_view_framebuffer() {
+		glGenTextures(1, &this->view_texture);
+		glBindTexture(GL_TEXTURE_2D, this->view_texture);
+		glTexImage2D(
+			GL_TEXTURE_2D, 
+			0, 
+			GL_RGBA8, 
+			Game_Properties::view.width, 
+			Game_Properties::view.height, 
+			0, 
+			GL_RGBA, 
+			GL_UNSIGNED_BYTE, 
+			NULL
+		);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		glGenFramebuffers(1, &this->view_framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, this->view_framebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->view_texture, 0);
+
+		const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			LOG_ERROR("View framebuffer is incomplete. Status: %x", status);
+			return false;
+		}
+
+		return true;
+	}
+
+	void present() {
+		this->set_blit_rect();
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, this->view_framebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		glViewport(0, 0, this->application.window.width, this->application.window.height);
+
+		// Clearing the whole window keeps the letterbox bars black.
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		glBlitFramebuffer(
+			0, 
+			0, 
+			Game_Properties::view.width, 
+			Game_Properties::view.height, 
+			this->blit_rect.x, 
+			this->blit_rect.y, 
+			this->blit_rect.x + this->blit_rect.width, 
+			this->blit_rect.y + this->blit_rect.height, 
+			GL_COLOR_BUFFER_BIT, 
+			GL_NEAREST
+		);
+	}
+
+	void set_blit_rect() {
 		if (this->application.window == cached_window_size) {
 			return;
 		} else {
 			this->cached_window_size = this->application.window;
-			this->log("%d, %d", this->application.window.width, this->application.window.height);
+			LOG_INFO("Window resized: %d, %d", this->application.window.width, this->application.window.height);
 		}
 
-		const float window_aspect_ratio = (float)this->application.window.width / this->application.window.height;
-		const float view_aspect_ratio = (float)Game_Properties::view.width / Game_Properties::view.height;
-		
-		GLsizei viewport_height;
-		GLsizei viewport_width;
+		const int width_scale = this->application.window.width / Game_Properties::view.width;
+		const int height_scale = this->application.window.height / Game_Properties::view.height;
+		const int scale = width_scale < height_scale ? width_scale : height_scale;
 
-		const bool snap_to_height = window_aspect_ratio > view_aspect_ratio;
-		if (snap_to_height) {
-			viewport_height = this->application.window.height;
-			viewport_width = (GLsizei)(viewport_height * view_aspect_ratio);
+		if (scale >= 1) {
+			// Integer scaling keeps every view pixel the same size on screen.
+			this->blit_rect.width = Game_Properties::view.width * scale;
+			this->blit_rect.height = Game_Properties::view.height * scale;
 		} else {
-			viewport_width = this->application.window.width;
-			viewport_height = (GLsizei)(viewport_width / view_aspect_ratio);
+			// The window is smaller than the view, fall back to fitting the 
+			// aspect ratio.
+			const float window_aspect_ratio = (float)this->application.window.width / this->application.window.height;
+			const float view_aspect_ratio = (float)Game_Properties::view.width / Game_Properties::view.height;
+
+			const bool snap_to_height = window_aspect_ratio > view_aspect_ratio;
+			if (snap_to_height) {
+				this->blit_rect.height = this->application.window.height;
+				this->blit_rect.width = (GLint)(this->blit_rect.height * view_aspect_ratio);
+			} else {
+				this->blit_rect.width = this->application.window.width;
+				this->blit_rect.height = (GLint)(this->blit_rect.width / view_aspect_ratio);
+			}
 		}
 
-		const GLsizei viewport_x = this->application.window.width / 2 - viewport_width / 2;
-		const GLsizei viewport_y = this->application.window.height / 2 - viewport_height / 2;
-
-		glViewport(viewport_x, viewport_y, viewport_width, viewport_height);
-	}
-
-	void log(const char *format, ...) const {
-		va_list args;
-		va_start(args, format);
-		const int message_length = vsnprintf(NULL, 0, format, args);
-		const int message_byte_length = sizeof(char) * (message_length + 1);
-		assert(message_length >= 0);
-		char *message = (char *)malloc(message_byte_length);
-		memset(message, 0, message_byte_length);
-		vsnprintf(message, message_byte_length, format, args);
-		va_end(args);
-
-		this->platform.log_info("GL Log: %s", message);
-		free(message);
+		this->blit_rect.x = this->application.window.width / 2 - this->blit_rect.width / 2;
+		this->blit_rect.y = this->application.window.height / 2 - this->blit_rect.height / 2;
 	}
 
 	void log_shader_compile_error(GLuint shader_id, const char *name, const char *shader_type) const {
@@ -491,7 +671,7 @@ private:
 			memset(message, 0, message_byte_length);
 			glGetShaderInfoLog(shader_id, message_length, NULL, message);
 
-			this->log("Shader (%s - %s) failed to compile. Message: %s", name, shader_type, message);
+			LOG_ERROR("Shader (%s - %s) failed to compile. Message: %s", name, shader_type, message);
 			free(message);
 		}
 	}
@@ -509,7 +689,7 @@ private:
 			memset(message, 0, message_byte_length);
 			glGetProgramInfoLog(program_id, message_length, NULL, message);
 
-			this->log("Program (%s) failed to link. Message: %s", name, message);
+			LOG_ERROR("Program (%s) failed to link. Message: %s", name, message);
 			free(message);
 		}
 	}
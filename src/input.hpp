@@ -1,19 +1,114 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+
+#include "array.hpp"
+
 struct Input {
 	bool flap = false;
 	bool hovering = false;
 
+	// When the pending flap was pressed, and when the last handled one was.
+	// Both are in platform monotonic time.
+	uint64_t flap_time_ns = 0;
+	uint64_t handled_flap_time_ns = 0;
+
 	void flap_handled() {
 		this->flap = false;
+		this->handled_flap_time_ns = this->flap_time_ns;
 	}
 
-	void input_down() {
+	void input_down(uint64_t time_ns) {
 		this->flap = true;
 		this->hovering = true;
+		this->flap_time_ns = time_ns;
 	}
 
 	void input_up() {
 		this->hovering = false;
 	}
+};
+
+struct Input_Event {
+	enum class Type {
+		down, 
+		up
+	};
+
+	Type type;
+	uint64_t time_ns;
+};
+
+// Input events waiting for the simulation tick they happened in. Events are
+// queued in the order they arrived and handed over to `Input` one tick at a
+// time, so several ticks in one frame each see their own input.
+struct Input_Queue {
+	Array<Input_Event, 64> events;
+
+	void push(Input_Event event) {
+		// Dropping the oldest is better than dropping the newest if the
+		// simulation stops ticking for a while.
+		if (this->events.length == 64) {
+			this->consume(1);
+		}
+		this->events.push(event);
+	}
+
+	// Applies every event that happened up to and including `tick_time_ns`.
+	void apply(Input *input, uint64_t tick_time_ns) {
+		size_t applied_count = 0;
+		for (const Input_Event &event : this->events) {
+			if (event.time_ns > tick_time_ns) {
+				break;
+			}
+
+			if (event.type == Input_Event::Type::down) {
+				input->input_down(event.time_ns);
+			} else {
+				input->input_up();
+			}
+			applied_count++;
+		}
+
+		this->consume(applied_count);
+	}
+
+private:
+	void consume(size_t count) {
+		for (size_t i = count; i < this->events.length; i++) {
+			this->events[i - count] = this->events[i];
+		}
+		this->events.length -= count;
+	}
+};
+
+// Millisecond buckets of the time between a press and the tick that flapped.
+struct Latency_Histogram {
+	static constexpr uint64_t bucket_width_ns = 1000000;
+
+	// The last bucket collects everything longer.
+	std::array<uint32_t, 64> buckets = {};
+	uint32_t count = 0;
+	uint64_t max_ns = 0;
+
+	void record(uint64_t latency_ns) {
+		const uint64_t bucket = latency_ns / bucket_width_ns;
+		this->buckets[bucket < this->buckets.size() ? bucket : this->buckets.size() - 1]++;
+		this->count++;
+		this->max_ns = latency_ns > this->max_ns ? latency_ns : this->max_ns;
+	}
+
+	// Upper edge of the bucket the percentile falls in.
+	uint64_t get_percentile_ns(float percentile) const {
+		const uint32_t target = (uint32_t)(this->count * percentile);
+		uint32_t seen = 0;
+		for (size_t i = 0; i < this->buckets.size(); i++) {
+			seen += this->buckets[i];
+			if (seen > target) {
+				return (i + 1) * bucket_width_ns;
+			}
+		}
+		return this->max_ns;
+	}
 };
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <utility>
+
 #include <glm/glm.hpp>
 
 #include "size.hpp"
@@ -21,4 +23,108 @@ inline bool circle_rect_intersection(
 	);
 	const glm::vec2 distance = closest - circle;
 	return glm::length(distance) <= radius;
+}
+
+// Earliest time in [0, 1] that the segment `start + direction * t` enters the
+// box, if it does.
+inline bool segment_box_intersection(glm::vec2 start, glm::vec2 direction, glm::vec2 min, glm::vec2 max, float *time) {
+	float t_enter = 0.0f;
+	float t_exit = 1.0f;
+
+	for (int axis = 0; axis < 2; axis++) {
+		if (direction[axis] == 0.0f) {
+			if (start[axis] < min[axis] || start[axis] > max[axis]) {
+				return false;
+			}
+			continue;
+		}
+
+		float t_near = (min[axis] - start[axis]) / direction[axis];
+		float t_far = (max[axis] - start[axis]) / direction[axis];
+		if (t_near > t_far) {
+			std::swap(t_near, t_far);
+		}
+
+		t_enter = glm::max(t_enter, t_near);
+		t_exit = glm::min(t_exit, t_far);
+		if (t_enter > t_exit) {
+			return false;
+		}
+	}
+
+	*time = t_enter;
+	return true;
+}
+
+// Earliest time in [0, 1] that the segment `start + direction * t` enters the
+// circle, if it does.
+inline bool segment_circle_intersection(glm::vec2 start, glm::vec2 direction, glm::vec2 centre, float radius, float *time) {
+	const glm::vec2 offset = start - centre;
+	const float c = glm::dot(offset, offset) - radius * radius;
+	if (c <= 0.0f) {
+		*time = 0.0f;
+		return true;
+	}
+
+	const float a = glm::dot(direction, direction);
+	const float b = 2.0f * glm::dot(offset, direction);
+	const float discriminant = b * b - 4.0f * a * c;
+	if (a == 0.0f || discriminant < 0.0f) {
+		return false;
+	}
+
+	const float t = (-b - sqrtf(discriminant)) / (2.0f * a);
+	if (t < 0.0f || t > 1.0f) {
+		return false;
+	}
+
+	*time = t;
+	return true;
+}
+
+// Sweeps a circle from `start` to `end` against a rectangle, so fast movement
+// can't tunnel through it. On a hit `time_of_impact` is the fraction of the
+// way along the sweep where they first touch.
+//
+// The circle is treated as a point against the rectangle grown by the radius,
+// which is the union of two stretched boxes and a circle on each corner.
+inline bool swept_circle_rect_intersection(
+	glm::vec2 start,
+	glm::vec2 end,
+	float radius,
+	glm::vec2 rect,
+	Size<float> rect_size,
+	float *time_of_impact
+) {
+	const glm::vec2 half_size = glm::vec2(rect_size.width / 2, rect_size.height / 2);
+	const glm::vec2 min = rect - half_size;
+	const glm::vec2 max = rect + half_size;
+	const glm::vec2 direction = end - start;
+
+	bool hit = false;
+	float earliest = 1.0f;
+	float time;
+
+	if (segment_box_intersection(start, direction, min - glm::vec2(radius, 0.0f), max + glm::vec2(radius, 0.0f), &time)) {
+		hit = true;
+		earliest = glm::min(earliest, time);
+	}
+
+	if (segment_box_intersection(start, direction, min - glm::vec2(0.0f, radius), max + glm::vec2(0.0f, radius), &time)) {
+		hit = true;
+		earliest = glm::min(earliest, time);
+	}
+
+	const glm::vec2 corners[4] = { min, max, glm::vec2(min.x, max.y), glm::vec2(max.x, min.y) };
+	for (const glm::vec2 &corner : corners) {
+		if (segment_circle_intersection(start, direction, corner, radius, &time)) {
+			hit = true;
+			earliest = glm::min(earliest, time);
+		}
+	}
+
+	if (hit) {
+		*time_of_impact = earliest;
+	}
+	return hit;
 }
\ No newline at end of file
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "persistent_game_state.hpp"
+#include "platform.hpp"
+#include "save_file.hpp"
+
+struct _Linux_Platform_File : Platform_File {
+	void *mapping;
+	size_t mapping_size;
+};
+
+struct Linux_Platform {
+private:
+	std::string base_path;
+	std::string save_directory;
+	std::string save_file_path;
+	std::string save_temp_file_path;
+
+	// Same latest-wins handoff as `SDL_Platform`, see there.
+	std::thread save_thread;
+	std::mutex save_mutex;
+	std::condition_variable save_condition;
+	Persistent_Game_State pending_save;
+	bool has_pending_save = false;
+	bool is_closing = false;
+
+public:
+	Linux_Platform() {
+		char executable_path[4096] = {};
+		const ssize_t length = readlink("/proc/self/exe", executable_path, sizeof(executable_path) - 1);
+		if (length > 0) {
+			this->base_path = std::string(executable_path, length);
+			this->base_path.erase(this->base_path.find_last_of('/') + 1);
+		}
+
+		// Follows the XDG base directory spec, falling back to
+		// ~/.local/share when XDG_DATA_HOME isn't set.
+		const char *data_home = getenv("XDG_DATA_HOME");
+		if (data_home != nullptr && data_home[0] == '/') {
+			this->save_directory = std::string(data_home) + "/flappy-bird/";
+		} else {
+			const char *home = getenv("HOME");
+			this->save_directory = std::string(home != nullptr ? home : ".") + "/.local/share/flappy-bird/";
+		}
+		this->save_file_path = this->save_directory + "save";
+		this->save_temp_file_path = this->save_file_path + ".tmp";
+		make_directories(this->save_directory);
+
+		this->save_thread = std::thread(&Linux_Platform::save_thread_main, this);
+	}
+
+	~Linux_Platform() {
+		{
+			std::lock_guard<std::mutex> lock(this->save_mutex);
+			this->is_closing = true;
+		}
+		this->save_condition.notify_one();
+		this->save_thread.join();
+	}
+
+	void log_error(const char *format, ...) const {
+		va_list args;
+		va_start(args, format);
+		log("ERROR", format, args);
+		va_end(args);
+	}
+
+	void log_info(const char *format, ...) const {
+		va_list args;
+		va_start(args, format);
+		log("INFO", format, args);
+		va_end(args);
+	}
+
+	void save(const Persistent_Game_State &state) {
+		{
+			std::lock_guard<std::mutex> lock(this->save_mutex);
+			this->pending_save = state;
+			this->has_pending_save = true;
+		}
+		this->save_condition.notify_one();
+	}
+
+	void load(Persistent_Game_State *state) const {
+		*state = {};
+
+		const int file = open(this->save_file_path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (file == -1) {
+			return;
+		}
+
+		Save_File::Buffer buffer = {};
+		const ssize_t length = read(file, buffer, sizeof(buffer));
+		close(file);
+
+		if (length < 0 || !Save_File::decode(buffer, (size_t)length, state)) {
+			this->log_error("Save file (%s) could not be read, starting fresh.", this->save_file_path.c_str());
+		}
+	}
+
+	// Maps the file read only rather than copying it, pages are only read in
+	// as they are touched.
+	void load_file(const char *path, Platform_File **file) const {
+		*file = nullptr;
+
+		const int descriptor = open(path, O_RDONLY | O_CLOEXEC);
+		if (descriptor == -1) {
+			this->log_error("Could not open file (%s).", path);
+			return;
+		}
+
+		struct stat file_stat;
+		if (fstat(descriptor, &file_stat) == -1) {
+			this->log_error("Could not stat file (%s).", path);
+			close(descriptor);
+			return;
+		}
+
+		_Linux_Platform_File *platform_file = new _Linux_Platform_File();
+		platform_file->content_size = (unsigned int)file_stat.st_size;
+		platform_file->mapping_size = (size_t)file_stat.st_size;
+		platform_file->mapping = nullptr;
+		platform_file->contents = "";
+
+		// Empty files can't be mapped.
+		if (platform_file->mapping_size > 0) {
+			platform_file->mapping = mmap(NULL, platform_file->mapping_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+			if (platform_file->mapping == MAP_FAILED) {
+				this->log_error("Could not map file (%s).", path);
+				close(descriptor);
+				delete platform_file;
+				return;
+			}
+
+			madvise(platform_file->mapping, platform_file->mapping_size, MADV_SEQUENTIAL);
+			platform_file->contents = (const char *)platform_file->mapping;
+		}
+
+		// The mapping stays valid after the descriptor is closed.
+		close(descriptor);
+
+		*file = (Platform_File *)platform_file;
+	}
+
+	void close_file(Platform_File **file) const {
+		_Linux_Platform_File *platform_file = (_Linux_Platform_File *)*file;
+		if (platform_file->mapping != nullptr) {
+			munmap(platform_file->mapping, platform_file->mapping_size);
+		}
+		delete platform_file;
+		*file = nullptr;
+	}
+
+	const std::string get_asset_path(const char *file_path) const {
+		return this->base_path + "assets/" + file_path;
+	}
+
+	uint64_t get_monotonic_time_ns() const {
+		timespec time;
+		clock_gettime(CLOCK_MONOTONIC, &time);
+		return (uint64_t)time.tv_sec * 1000000000 + (uint64_t)time.tv_nsec;
+	}
+
+private:
+	static void log(const char *level, const char *format, va_list args) {
+		char message[1024];
+		vsnprintf(message, sizeof(message), format, args);
+		fprintf(stderr, "%s: %s\n", level, message);
+	}
+
+	static void make_directories(const std::string &path) {
+		for (size_t i = 1; i < path.size(); i++) {
+			if (path[i] == '/') {
+				mkdir(path.substr(0, i).c_str(), 0755);
+			}
+		}
+	}
+
+	void save_thread_main() {
+		std::unique_lock<std::mutex> lock(this->save_mutex);
+		while (true) {
+			this->save_condition.wait(lock, [this] { return this->has_pending_save || this->is_closing; });
+			if (!this->has_pending_save) {
+				break;
+			}
+
+			Save_File::Buffer buffer;
+			Save_File::encode(this->pending_save, buffer);
+			this->has_pending_save = false;
+
+			lock.unlock();
+			if (!this->write_file_atomic(buffer, sizeof(buffer))) {
+				this->log_error("Could not write save file (%s).", this->save_file_path.c_str());
+			}
+			lock.lock();
+		}
+	}
+
+	// Write to a temporary file, fsync, then rename over the real file. The
+	// directory is synced too so the rename itself survives a power cut.
+	bool write_file_atomic(const uint8_t *data, size_t length) const {
+		const int file = open(this->save_temp_file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (file == -1) {
+			return false;
+		}
+
+		bool success = write(file, data, length) == (ssize_t)length && fsync(file) == 0;
+		success = close(file) == 0 && success;
+		if (!success || rename(this->save_temp_file_path.c_str(), this->save_file_path.c_str()) != 0) {
+			return false;
+		}
+
+		const int directory = open(this->save_directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (directory != -1) {
+			fsync(directory);
+			close(directory);
+		}
+
+		return true;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+#include "ring_buffer.hpp"
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_ERROR 2
+#define LOG_LEVEL_NONE 3
+
+// Messages below `LOG_LEVEL` are compiled out entirely, arguments included.
+#ifndef LOG_LEVEL
+	#ifdef NDEBUG
+		#define LOG_LEVEL LOG_LEVEL_INFO
+	#else
+		#define LOG_LEVEL LOG_LEVEL_DEBUG
+	#endif
+#endif
+
+// The format must be a string literal, only its pointer is stored.
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+	#define LOG_DEBUG(...) global_logger.write(Log_Level::debug, __VA_ARGS__)
+#else
+	#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+	#define LOG_INFO(...) global_logger.write(Log_Level::info, __VA_ARGS__)
+#else
+	#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+	#define LOG_ERROR(...) global_logger.write(Log_Level::error, __VA_ARGS__)
+#else
+	#define LOG_ERROR(...) ((void)0)
+#endif
+
+enum class Log_Level : uint8_t {
+	debug,
+	info,
+	error
+};
+
+struct Log_Argument {
+	enum class Type : uint8_t {
+		integer,
+		floating,
+		string,
+		pointer
+	};
+
+	Type type;
+	union {
+		int64_t integer;
+		double floating;
+		uint16_t string_offset;
+		const void *pointer;
+	};
+};
+
+// Everything needed to format a message later. Strings are the only
+// arguments copied by value, as they rarely outlive the call.
+struct Log_Record {
+	static constexpr size_t max_arguments = 8;
+	static constexpr size_t string_capacity = 128;
+
+	const char *format;
+	Log_Level level;
+	uint8_t argument_count;
+	uint16_t string_length;
+	Log_Argument arguments[max_arguments];
+	char strings[string_capacity];
+};
+
+using Log_Sink = void (*)(Log_Level level, const char *message);
+
+struct Logger {
+	~Logger() {
+		this->stop();
+	}
+
+	// Records written before `start` are kept and written once it is called.
+	void start(Log_Sink sink) {
+		this->sink = sink;
+		this->running = true;
+		this->thread = std::thread(&Logger::thread_main, this);
+	}
+
+	// Writes out everything still queued before returning.
+	void stop() {
+		if (!this->running) {
+			return;
+		}
+
+		this->running = false;
+		this->thread.join();
+	}
+
+	template<typename... Args>
+	void write(Log_Level level, const char *format, Args... args) {
+		static_assert(sizeof...(Args) <= Log_Record::max_arguments, "Too many log arguments.");
+
+		Log_Record record;
+		record.format = format;
+		record.level = level;
+		record.argument_count = 0;
+		record.string_length = 0;
+		(capture(&record, args), ...);
+
+		if (!this->records.push(record)) {
+			this->dropped_count.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	uint64_t get_dropped_count() const {
+		return this->dropped_count.load(std::memory_order_relaxed);
+	}
+
+private:
+	Mpsc_Ring_Buffer<Log_Record, 512> records;
+	std::atomic<uint64_t> dropped_count = 0;
+	std::atomic<bool> running = false;
+	std::thread thread;
+	Log_Sink sink = nullptr;
+
+	template<typename T>
+	static void capture(Log_Record *record, T value) {
+		Log_Argument &argument = record->arguments[record->argument_count++];
+
+		if constexpr (std::is_same_v<T, const char *> || std::is_same_v<T, char *>) {
+			argument.type = Log_Argument::Type::string;
+			argument.string_offset = record->string_length;
+
+			const char *string = value != nullptr ? value : "(null)";
+			const size_t available = Log_Record::string_capacity - record->string_length;
+			const size_t length = available > 0 ? strnlen(string, available - 1) : 0;
+			if (available > 0) {
+				memcpy(record->strings + record->string_length, string, length);
+				record->strings[record->string_length + length] = '\0';
+				record->string_length += (uint16_t)(length + 1);
+			} else {
+				argument.string_offset = Log_Record::string_capacity - 1;
+			}
+		} else if constexpr (std::is_floating_point_v<T>) {
+			argument.type = Log_Argument::Type::floating;
+			argument.floating = (double)value;
+		} else if constexpr (std::is_pointer_v<T>) {
+			argument.type = Log_Argument::Type::pointer;
+			argument.pointer = (const void *)value;
+		} else {
+			static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "Unsupported log argument type.");
+			argument.type = Log_Argument::Type::integer;
+			argument.integer = (int64_t)value;
+		}
+	}
+
+	// Formats one printf conversion at a time with the captured argument,
+	// widening integer conversions to 64 bits.
+	static void format_record(const Log_Record &record, char *message, size_t message_size) {
+		size_t length = 0;
+		size_t argument_index = 0;
+		const char *cursor = record.format;
+
+		while (*cursor != '\0' && length < message_size - 1) {
+			if (*cursor != '%') {
+				message[length++] = *cursor++;
+				continue;
+			}
+
+			if (cursor[1] == '%') {
+				message[length++] = '%';
+				cursor += 2;
+				continue;
+			}
+
+			char specifier[32] = "%";
+			size_t specifier_length = 1;
+			cursor++;
+			while (*cursor != '\0' && strchr("-+ #0123456789.", *cursor) != nullptr && specifier_length < 24) {
+				specifier[specifier_length++] = *cursor++;
+			}
+			while (*cursor != '\0' && strchr("hlLqjzt", *cursor) != nullptr) {
+				cursor++;
+			}
+
+			const char conversion = *cursor;
+			if (conversion == '\0') {
+				break;
+			}
+			cursor++;
+
+			if (argument_index >= record.argument_count) {
+				length += snprintf(message + length, message_size - length, "(missing)");
+				length = length < message_size ? length : message_size - 1;
+				continue;
+			}
+
+			const Log_Argument &argument = record.arguments[argument_index++];
+			const size_t remaining = message_size - length;
+			int written = 0;
+			if (strchr("di", conversion) != nullptr) {
+				memcpy(specifier + specifier_length, "ll", 2);
+				specifier[specifier_length + 2] = conversion;
+				written = snprintf(message + length, remaining, specifier, (long long)argument.integer);
+			} else if (strchr("uxXo", conversion) != nullptr) {
+				memcpy(specifier + specifier_length, "ll", 2);
+				specifier[specifier_length + 2] = conversion;
+				written = snprintf(message + length, remaining, specifier, (unsigned long long)argument.integer);
+			} else if (conversion == 'c') {
+				specifier[specifier_length] = conversion;
+				written = snprintf(message + length, remaining, specifier, (int)argument.integer);
+			} else if (strchr("fFeEgGaA", conversion) != nullptr) {
+				specifier[specifier_length] = conversion;
+				const double value = argument.type == Log_Argument::Type::floating ? argument.floating : (double)argument.integer;
+				written = snprintf(message + length, remaining, specifier, value);
+			} else if (conversion == 's' && argument.type == Log_Argument::Type::string) {
+				specifier[specifier_length] = conversion;
+				written = snprintf(message + length, remaining, specifier, record.strings + argument.string_offset);
+			} else if (conversion == 'p') {
+				specifier[specifier_length] = conversion;
+				written = snprintf(message + length, remaining, specifier, argument.pointer);
+			} else {
+				written = snprintf(message + length, remaining, "(bad format)");
+			}
+
+			if (written > 0) {
+				length += (size_t)written < remaining ? (size_t)written : remaining - 1;
+			}
+		}
+
+		message[length] = '\0';
+	}
+
+	void drain() {
+		Log_Record record;
+		char message[1024];
+		while (this->records.pop(&record)) {
+			format_record(record, message, sizeof(message));
+			this->sink(record.level, message);
+		}
+	}
+
+	void thread_main() {
+		while (this->running) {
+			this->drain();
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		}
+
+		this->drain();
+	}
+};
+
+inline Logger global_logger;
\ No newline at end of file
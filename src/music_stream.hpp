@@ -0,0 +1,233 @@
+#pragma once
+
+#include <atomic>
+
+#include <SDL2/SDL.h>
+
+#include "logger.hpp"
+#include "ring_buffer.hpp"
+
+// Streams a long WAV track from disk. A background thread decodes it in
+// chunks into a ring buffer which the audio callback drains, so only a small
+// window of the track is ever in memory. The track loops seamlessly.
+struct Music_Stream {
+	static constexpr size_t chunk_size = 16 * 1024;
+
+	// Roughly 0.7 seconds of 48 kHz stereo.
+	static constexpr size_t ring_length = 64 * 1024;
+
+	~Music_Stream() {
+		this->close();
+	}
+
+	bool open(const char *path, int channels, int frequency) {
+		this->file = SDL_RWFromFile(path, "rb");
+		if (this->file == nullptr) {
+			return false;
+		}
+
+		SDL_AudioFormat format;
+		Uint8 file_channels;
+		int file_frequency;
+		if (!this->read_header(&format, &file_channels, &file_frequency)) {
+			LOG_ERROR("Music (%s) is not a supported WAV file.", path);
+			this->close();
+			return false;
+		}
+
+		// The audio stream keeps resampler state across chunks, so chunk
+		// boundaries and the loop point don't click.
+		this->stream = SDL_NewAudioStream(
+			format,
+			file_channels,
+			file_frequency,
+			AUDIO_F32SYS,
+			channels,
+			frequency
+		);
+
+		if (this->stream == nullptr) {
+			LOG_ERROR("%s", SDL_GetError());
+			this->close();
+			return false;
+		}
+
+		SDL_RWseek(this->file, this->data_start, RW_SEEK_SET);
+		this->running = true;
+		this->thread = SDL_CreateThread(decode_thread, "Music Decode", this);
+		if (this->thread == nullptr) {
+			LOG_ERROR("%s", SDL_GetError());
+			this->close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void close() {
+		this->running = false;
+		if (this->thread != nullptr) {
+			SDL_WaitThread(this->thread, NULL);
+			this->thread = nullptr;
+		}
+
+		if (this->stream != nullptr) {
+			SDL_FreeAudioStream(this->stream);
+			this->stream = nullptr;
+		}
+
+		if (this->file != nullptr) {
+			SDL_RWclose(this->file);
+			this->file = nullptr;
+		}
+	}
+
+	// Called from the audio thread. If the decoder has fallen behind the
+	// missing samples are left silent.
+	void mix(float *samples, Uint32 sample_count, float gain) {
+		while (sample_count > 0) {
+			const size_t requested = sample_count > sizeof(this->mix_buffer) / sizeof(float)
+				? sizeof(this->mix_buffer) / sizeof(float)
+				: sample_count;
+			const size_t read_count = this->ring.read(this->mix_buffer, requested);
+			for (size_t i = 0; i < read_count; i++) {
+				samples[i] += this->mix_buffer[i] * gain;
+			}
+
+			if (read_count < requested) {
+				return;
+			}
+
+			samples += read_count;
+			sample_count -= (Uint32)read_count;
+		}
+	}
+
+private:
+	SDL_RWops *file = nullptr;
+	SDL_AudioStream *stream = nullptr;
+	SDL_Thread *thread = nullptr;
+	std::atomic<bool> running = false;
+
+	Sint64 data_start = 0;
+	Sint64 data_end = 0;
+
+	// Only used by the decode thread.
+	Uint8 chunk[chunk_size];
+	float converted[chunk_size];
+
+	// Only used by the audio thread.
+	float mix_buffer[1024];
+
+	Spsc_Ring_Buffer<float, ring_length> ring;
+
+	bool read_header(SDL_AudioFormat *format, Uint8 *channels, int *frequency) {
+		char id[4];
+		if (SDL_RWread(this->file, id, 4, 1) != 1 || SDL_memcmp(id, "RIFF", 4) != 0) {
+			return false;
+		}
+
+		SDL_ReadLE32(this->file);
+		if (SDL_RWread(this->file, id, 4, 1) != 1 || SDL_memcmp(id, "WAVE", 4) != 0) {
+			return false;
+		}
+
+		bool found_format = false;
+		while (SDL_RWread(this->file, id, 4, 1) == 1) {
+			const Uint32 chunk_length = SDL_ReadLE32(this->file);
+			const Sint64 chunk_start = SDL_RWtell(this->file);
+
+			if (SDL_memcmp(id, "fmt ", 4) == 0) {
+				const Uint16 format_tag = SDL_ReadLE16(this->file);
+				*channels = (Uint8)SDL_ReadLE16(this->file);
+				*frequency = (int)SDL_ReadLE32(this->file);
+				SDL_ReadLE32(this->file); // Byte rate
+				SDL_ReadLE16(this->file); // Block align
+				const Uint16 bits_per_sample = SDL_ReadLE16(this->file);
+
+				const Uint16 pcm = 1;
+				const Uint16 ieee_float = 3;
+				if (format_tag == pcm && bits_per_sample == 8) {
+					*format = AUDIO_U8;
+				} else if (format_tag == pcm && bits_per_sample == 16) {
+					*format = AUDIO_S16LSB;
+				} else if (format_tag == pcm && bits_per_sample == 32) {
+					*format = AUDIO_S32LSB;
+				} else if (format_tag == ieee_float && bits_per_sample == 32) {
+					*format = AUDIO_F32LSB;
+				} else {
+					return false;
+				}
+
+				found_format = true;
+			} else if (SDL_memcmp(id, "data", 4) == 0) {
+				// There would be nothing to loop over.
+				if (chunk_length == 0) {
+					return false;
+				}
+
+				this->data_start = chunk_start;
+				this->data_end = chunk_start + chunk_length;
+				return found_format;
+			}
+
+			// Chunks are padded to an even length.
+			SDL_RWseek(this->file, chunk_start + chunk_length + (chunk_length & 1), RW_SEEK_SET);
+		}
+
+		return false;
+	}
+
+	// Reads the next chunk of the track into the audio stream, wrapping back
+	// to the start of the data when the end is reached.
+	bool feed_chunk() {
+		size_t chunk_length = 0;
+		while (chunk_length < chunk_size) {
+			const Sint64 position = SDL_RWtell(this->file);
+			if (position >= this->data_end) {
+				SDL_RWseek(this->file, this->data_start, RW_SEEK_SET);
+				continue;
+			}
+
+			const Sint64 remaining = this->data_end - position;
+			const size_t wanted = chunk_size - chunk_length;
+			const size_t length = remaining < (Sint64)wanted ? (size_t)remaining : wanted;
+			const size_t read_length = SDL_RWread(this->file, this->chunk + chunk_length, 1, length);
+			if (read_length == 0) {
+				return false;
+			}
+
+			chunk_length += read_length;
+		}
+
+		return SDL_AudioStreamPut(this->stream, this->chunk, (int)chunk_length) == 0;
+	}
+
+	static int decode_thread(void *data) {
+		Music_Stream *music = (Music_Stream *)data;
+
+		while (music->running) {
+			if (music->ring.free_length() < chunk_size) {
+				SDL_Delay(5);
+				continue;
+			}
+
+			if (SDL_AudioStreamAvailable(music->stream) < (int)sizeof(music->converted)) {
+				if (!music->feed_chunk()) {
+					LOG_ERROR("Music stream stopped: %s", SDL_GetError());
+					return -1;
+				}
+			}
+
+			const int converted_length = SDL_AudioStreamGet(music->stream, music->converted, sizeof(music->converted));
+			if (converted_length < 0) {
+				LOG_ERROR("%s", SDL_GetError());
+				return -1;
+			}
+
+			music->ring.write(music->converted, converted_length / sizeof(float));
+		}
+
+		return 0;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "platform.hpp"
+
+#ifdef LINUX
+#include "linux_platform.hpp"
+using Native_Platform = Linux_Platform;
+#else
+#include "sdl_platform.hpp"
+using Native_Platform = SDL_Platform;
+#endif
+
+static_assert(Platform_Backend<Native_Platform>);
\ No newline at end of file
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+#include "affine.hpp"
+#include "array.hpp"
+#include "debug_state.hpp"
+#include "game_properties.hpp"
+#include "game_state.hpp"
+
+// Frame stats drawn over the game, built by the render thread from
+// `Debug_State::frame_stats`. Frames that take well over the average show in
+// red on the graph, so hitches stand out without a profiler attached.
+struct Performance_Overlay {
+	static constexpr float text_scale = 0.5f;
+	static constexpr float line_height = 10.0f;
+	static constexpr float bar_width = 2.0f;
+	static constexpr float graph_height = 50.0f;
+
+	// Milliseconds of frame time the graph fits, taller bars are clipped.
+	static constexpr float graph_ms = 50.0f;
+	static constexpr float hitch_scale = 1.5f;
+
+	Array<Text, 6> text;
+
+	// The panel, the average line and a bar per frame.
+	Array<Shape, Frame_Stats_Window::capacity + 2> shapes;
+
+	void build(const Frame_Stats_Window &window) {
+		this->text.clear();
+		this->shapes.clear();
+
+		const size_t length = window.get_length();
+		if (length == 0) {
+			return;
+		}
+
+		const Frame_Stats total = window.get_total();
+		const double average_frame_ms = total.frame_ns / 1e6 / length;
+
+		// Sits above the floor, in the bottom left of the view.
+		const float left = -(float)Game_Properties::view.width / 2 + 4.0f;
+		const float bottom = -(float)Game_Properties::view.height / 2 + 36.0f;
+		const float panel_height = graph_height + line_height * this->text.capacity + 8.0f;
+
+		// Listed top down.
+		float y = bottom + panel_height - line_height / 2 - 2.0f;
+		Text *line = this->push_line(left + 4.0f, &y);
+		snprintf(line->text, sizeof(line->text), "FRAME %.2f MS", average_frame_ms);
+		line = this->push_line(left + 4.0f, &y);
+		snprintf(line->text, sizeof(line->text), "MAX FRAME %.2f MS", window.get_max_frame_ns() / 1e6);
+		line = this->push_line(left + 4.0f, &y);
+		snprintf(line->text, sizeof(line->text), "TICKS %.2f PER FRAME", (double)total.tick_count / length);
+		line = this->push_line(left + 4.0f, &y);
+		snprintf(line->text, sizeof(line->text), "SIM %.3f MS", total.sim_ns / 1e6 / length);
+		line = this->push_line(left + 4.0f, &y);
+		snprintf(line->text, sizeof(line->text), "RENDER %.3f MS", total.render_ns / 1e6 / length);
+		line = this->push_line(left + 4.0f, &y);
+		snprintf(line->text, sizeof(line->text), "DRAW CALLS %.0f", (double)total.draw_call_count / length);
+
+		// Wide enough for the graph and the longest line.
+		float content_width = bar_width * Frame_Stats_Window::capacity;
+		for (const Text &text : this->text) {
+			content_width = glm::max(content_width, get_text_width(text));
+		}
+		const float panel_width = content_width + 8.0f;
+
+		this->push_rectangle(
+			glm::vec2(left + panel_width / 2, bottom + panel_height / 2),
+			Size<float> { .width = panel_width, .height = panel_height },
+			glm::vec4(0.0f, 0.0f, 0.0f, 0.6f)
+		);
+
+		const float graph_left = left + 4.0f;
+		const float graph_bottom = bottom + 4.0f;
+		const float average_height = get_bar_height(average_frame_ms);
+		this->push_rectangle(
+			glm::vec2(graph_left + bar_width * Frame_Stats_Window::capacity / 2, graph_bottom + average_height),
+			Size<float> { .width = bar_width * Frame_Stats_Window::capacity, .height = 1.0f },
+			glm::vec4(1.0f, 1.0f, 1.0f, 0.5f)
+		);
+
+		for (size_t i = 0; i < length; i++) {
+			const double frame_ms = window.get(i).frame_ns / 1e6;
+			const float height = get_bar_height(frame_ms);
+			const bool is_hitch = frame_ms > average_frame_ms * hitch_scale;
+			this->push_rectangle(
+				glm::vec2(graph_left + bar_width * i + bar_width / 2, graph_bottom + height / 2),
+				Size<float> { .width = bar_width, .height = height },
+				is_hitch ? glm::vec4(1.0f, 0.2f, 0.2f, 1.0f) : glm::vec4(0.3f, 0.9f, 0.3f, 1.0f)
+			);
+		}
+	}
+
+private:
+	static float get_text_width(const Text &text) {
+		return strlen(text.text) * Game_Properties::font_size * text.scale.x;
+	}
+
+	static float get_bar_height(double frame_ms) {
+		const float height = (float)(frame_ms / graph_ms) * graph_height;
+		return height < graph_height ? (height > 1.0f ? height : 1.0f) : graph_height;
+	}
+
+	void push_rectangle(glm::vec2 position, Size<float> size, glm::vec4 colour) {
+		Shape shape = {};
+		shape.transform = Affine::from(position, 0.0f, glm::vec2(1.0f));
+		shape.type = Shape_Type::rectangle;
+		shape.rectangle = size;
+		shape.colour = colour;
+		this->shapes.push(shape);
+	}
+
+	Text *push_line(float x, float *y) {
+		Text line = {};
+		line.position = glm::vec2(x, *y);
+		line.scale = glm::vec2(text_scale);
+		line.colour = glm::vec4(1.0f);
+		line.alignment = Text_Alignment::left;
+		*y -= line_height;
+		return &this->text.push(line);
+	}
+};
\ No newline at end of file
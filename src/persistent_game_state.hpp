@@ -1,5 +1,30 @@
 #pragma once
 
+#include <array>
+
+// Everything that survives between play sessions. See `save_file.hpp` for
+// how it is stored on disk.
 struct Persistent_Game_State {
 	int high_score = 0;
+	int games_played = 0;
+
+	// Most recent run first.
+	int recent_score_count = 0;
+	std::array<int, 10> recent_scores = {};
+
+	void record_game(int score) {
+		this->games_played++;
+		if (score > this->high_score) {
+			this->high_score = score;
+		}
+
+		for (size_t i = this->recent_scores.size() - 1; i > 0; i--) {
+			this->recent_scores[i] = this->recent_scores[i - 1];
+		}
+
+		this->recent_scores[0] = score;
+		if (this->recent_score_count < (int)this->recent_scores.size()) {
+			this->recent_score_count++;
+		}
+	}
 };
\ No newline at end of file
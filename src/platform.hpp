@@ -1,18 +1,48 @@
 #pragma once
 
+#include <concepts>
+#include <cstdint>
 #include <string>
 
+#include "persistent_game_state.hpp"
+
+// Read only view of a whole file. `contents` is not guaranteed to be null
+// terminated, always use `content_size`.
 struct Platform_File {
 	unsigned int content_size;
-	char *contents;
+	const char *contents;
+};
+
+// Platforms are picked at compile time, see `native_platform.hpp`, so calls
+// into them are direct and can be inlined.
+template<typename T>
+concept Platform_Backend = requires(
+	T platform, 
+	const T const_platform, 
+	const Persistent_Game_State &state, 
+	Persistent_Game_State *state_out, 
+	Platform_File **file
+) {
+	const_platform.log_error("");
+	const_platform.log_info("");
+	// Queues the state to be written in the background, the caller never waits
+	// on the disk.
+	platform.save(state);
+	const_platform.load(state_out);
+	// Sets `file` to null if the file could not be opened.
+	const_platform.load_file("", file);
+	const_platform.close_file(file);
+	{ const_platform.get_asset_path("") } -> std::convertible_to<std::string>;
+	{ const_platform.get_monotonic_time_ns() } -> std::same_as<uint64_t>;
+};
+
+// All the simulation needs from a platform.
+template<typename T>
+concept Storage_Backend = requires(T storage, const Persistent_Game_State &state) {
+	storage.save(state);
 };
 
-struct Platform {
-	virtual void log_error(const char *format, ...) const = 0;
-	virtual void log_info(const char *format, ...) const = 0;
-	virtual void save_high_score(int score) const = 0;
-	virtual int get_high_score() const = 0;
-	virtual void load_file(const char *path, Platform_File **file) const = 0;
-	virtual void close_file(Platform_File **file) const = 0;
-	virtual const std::string get_asset_path(const char *file_path) const = 0;
+// For headless runs, where nothing should reach the disk.
+struct Null_Storage {
+	void save(const Persistent_Game_State &) {}
 };
\ No newline at end of file
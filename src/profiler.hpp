@@ -0,0 +1,192 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <intrin.h>
+	#define PROFILE_HAS_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+	#include <x86intrin.h>
+	#define PROFILE_HAS_TSC 1
+#endif
+
+// Zones cost two reads of the CPU's cycle counter and a store into a ring
+// owned by the thread, so they can stay in hot paths. Set `PROFILE_ENABLED`
+// to 0 to compile them out.
+#ifndef PROFILE_ENABLED
+	#define PROFILE_ENABLED 1
+#endif
+
+#define _PROFILE_CONCAT_INNER(a, b) a##b
+#define _PROFILE_CONCAT(a, b) _PROFILE_CONCAT_INNER(a, b)
+
+// The name must be a string literal, only its pointer is stored.
+#if PROFILE_ENABLED
+	#define PROFILE_ZONE(name) const Profile_Zone _PROFILE_CONCAT(_profile_zone_, __LINE__)(name)
+	#define PROFILE_THREAD(name) Profiler::set_thread_name(name)
+#else
+	#define PROFILE_ZONE(name) ((void)0)
+	#define PROFILE_THREAD(name) ((void)0)
+#endif
+
+// Times are in `Profiler::get_ticks` units, only converted when written out.
+struct Profile_Sample {
+	const char *name;
+	uint64_t start_ticks;
+	uint64_t end_ticks;
+};
+
+// Written only by its own thread. Once full the oldest samples are
+// overwritten, so a trace always holds the latest stretch of time.
+struct Profile_Ring {
+	static constexpr size_t capacity = 8192;
+
+	Profile_Sample samples[capacity];
+	std::atomic<uint64_t> write_count = 0;
+	const char *thread_name = nullptr;
+
+	void push(const Profile_Sample &sample) {
+		const uint64_t write_count = this->write_count.load(std::memory_order_relaxed);
+		this->samples[write_count & (capacity - 1)] = sample;
+		this->write_count.store(write_count + 1, std::memory_order_release);
+	}
+};
+
+namespace Profiler {
+	// Rings are handed out from a fixed pool the first time a thread records
+	// anything, so profiling never touches the heap. Threads past the limit
+	// go unrecorded.
+	constexpr size_t max_threads = 8;
+
+	inline Profile_Ring rings[max_threads];
+	inline std::atomic<size_t> ring_count = 0;
+	inline thread_local Profile_Ring *thread_ring = nullptr;
+	inline thread_local bool has_claimed_ring = false;
+
+	inline uint64_t get_time_ns() {
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()
+		).count();
+	}
+
+	// The cycle counter where there is one, as it is several times cheaper to
+	// read than the OS clock. Otherwise nanoseconds.
+	inline uint64_t get_ticks() {
+		#if PROFILE_HAS_TSC
+		return __rdtsc();
+		#else
+		return get_time_ns();
+		#endif
+	}
+
+	// Taken at startup, so the rate of ticks can be measured against the OS
+	// clock when a trace is written.
+	inline const uint64_t start_ticks = get_ticks();
+	inline const uint64_t start_ns = get_time_ns();
+
+	inline Profile_Ring *get_thread_ring() {
+		if (!has_claimed_ring) {
+			has_claimed_ring = true;
+			const size_t index = ring_count.fetch_add(1, std::memory_order_relaxed);
+			thread_ring = index < max_threads ? &rings[index] : nullptr;
+		}
+		return thread_ring;
+	}
+
+	inline void set_thread_name(const char *name) {
+		Profile_Ring *ring = get_thread_ring();
+		if (ring != nullptr) {
+			ring->thread_name = name;
+		}
+	}
+
+	inline void record(const char *name, uint64_t start_ticks, uint64_t end_ticks) {
+		Profile_Ring *ring = get_thread_ring();
+		if (ring != nullptr) {
+			ring->push({ .name = name, .start_ticks = start_ticks, .end_ticks = end_ticks });
+		}
+	}
+
+	// Samples older than this may be overwritten while a trace is written,
+	// so they are left out of it.
+	inline uint64_t get_first_kept_sample(uint64_t write_count) {
+		const uint64_t kept_capacity = Profile_Ring::capacity - Profile_Ring::capacity / 8;
+		return write_count > kept_capacity ? write_count - kept_capacity : 0;
+	}
+
+	// Writes every ring as Chrome trace event JSON, which Perfetto and
+	// chrome://tracing both open. Other threads can keep recording meanwhile.
+	inline bool write_chrome_trace(const char *path) {
+		FILE *file = fopen(path, "wb");
+		if (file == nullptr) {
+			return false;
+		}
+
+		const size_t thread_count = ring_count.load(std::memory_order_acquire);
+		const size_t ring_total = thread_count < max_threads ? thread_count : max_threads;
+
+		const uint64_t elapsed_ticks = get_ticks() - start_ticks;
+		const double microseconds_per_tick = elapsed_ticks > 0 ? (get_time_ns() - start_ns) / 1e3 / elapsed_ticks : 0.0;
+
+		// Times are written relative to the earliest sample kept.
+		uint64_t first_ticks = UINT64_MAX;
+		uint64_t write_counts[max_threads];
+		for (size_t ring_i = 0; ring_i < ring_total; ring_i++) {
+			const Profile_Ring &ring = rings[ring_i];
+			write_counts[ring_i] = ring.write_count.load(std::memory_order_acquire);
+			for (uint64_t i = get_first_kept_sample(write_counts[ring_i]); i < write_counts[ring_i]; i++) {
+				const uint64_t sample_ticks = ring.samples[i & (Profile_Ring::capacity - 1)].start_ticks;
+				first_ticks = sample_ticks < first_ticks ? sample_ticks : first_ticks;
+			}
+		}
+
+		fprintf(file, "{\"traceEvents\":[\n");
+		bool is_first_event = true;
+		for (size_t ring_i = 0; ring_i < ring_total; ring_i++) {
+			const Profile_Ring &ring = rings[ring_i];
+			const char *thread_name = ring.thread_name != nullptr ? ring.thread_name : "Thread";
+			fprintf(
+				file,
+				"%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s\"}}",
+				is_first_event ? "" : ",\n",
+				ring_i,
+				thread_name
+			);
+			is_first_event = false;
+
+			for (uint64_t i = get_first_kept_sample(write_counts[ring_i]); i < write_counts[ring_i]; i++) {
+				const Profile_Sample &sample = ring.samples[i & (Profile_Ring::capacity - 1)];
+				if (sample.start_ticks < first_ticks || sample.end_ticks < sample.start_ticks) {
+					continue;
+				}
+
+				fprintf(
+					file,
+					",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}",
+					sample.name,
+					ring_i,
+					(sample.start_ticks - first_ticks) * microseconds_per_tick,
+					(sample.end_ticks - sample.start_ticks) * microseconds_per_tick
+				);
+			}
+		}
+		fprintf(file, "\n]}\n");
+
+		return fclose(file) == 0;
+	}
+};
+
+struct Profile_Zone {
+	const char *name;
+	uint64_t start_ticks;
+
+	Profile_Zone(const char *name) : name{name}, start_ticks{Profiler::get_ticks()} {}
+
+	~Profile_Zone() {
+		Profiler::record(this->name, this->start_ticks, Profiler::get_ticks());
+	}
+};
\ No newline at end of file
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+// Single producer, single consumer ring buffer. One thread may push while 
+// another pops without any locking.
+template<typename T, size_t Size>
+struct Spsc_Ring_Buffer {
+	static_assert(Size > 0 && (Size & (Size - 1)) == 0, "Size must be a power of two.");
+
+	bool push(const T &value) {
+		const size_t write_index = this->write_index.load(std::memory_order_relaxed);
+		const size_t read_index = this->read_index.load(std::memory_order_acquire);
+		if (write_index - read_index == Size) {
+			return false;
+		}
+
+		this->data[write_index & (Size - 1)] = value;
+		this->write_index.store(write_index + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T *value) {
+		const size_t read_index = this->read_index.load(std::memory_order_relaxed);
+		const size_t write_index = this->write_index.load(std::memory_order_acquire);
+		if (read_index == write_index) {
+			return false;
+		}
+
+		*value = this->data[read_index & (Size - 1)];
+		this->read_index.store(read_index + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Bulk versions of push and pop for plain data such as audio samples. They
+	// transfer as many values as fit and return how many that was.
+	size_t write(const T *values, size_t count) {
+		const size_t write_index = this->write_index.load(std::memory_order_relaxed);
+		const size_t read_index = this->read_index.load(std::memory_order_acquire);
+		const size_t free_count = Size - (write_index - read_index);
+		count = count > free_count ? free_count : count;
+
+		const size_t start = write_index & (Size - 1);
+		const size_t first_count = count > Size - start ? Size - start : count;
+		std::copy(values, values + first_count, this->data + start);
+		std::copy(values + first_count, values + count, this->data);
+
+		this->write_index.store(write_index + count, std::memory_order_release);
+		return count;
+	}
+
+	size_t read(T *values, size_t count) {
+		const size_t read_index = this->read_index.load(std::memory_order_relaxed);
+		const size_t write_index = this->write_index.load(std::memory_order_acquire);
+		const size_t available_count = write_index - read_index;
+		count = count > available_count ? available_count : count;
+
+		const size_t start = read_index & (Size - 1);
+		const size_t first_count = count > Size - start ? Size - start : count;
+		std::copy(this->data + start, this->data + start + first_count, values);
+		std::copy(this->data, this->data + (count - first_count), values + first_count);
+
+		this->read_index.store(read_index + count, std::memory_order_release);
+		return count;
+	}
+
+	size_t free_length() const {
+		return Size - this->length();
+	}
+
+	size_t length() const {
+		return this->write_index.load(std::memory_order_acquire) - this->read_index.load(std::memory_order_acquire);
+	}
+
+private:
+	// Kept on separate cache lines so the producer and consumer don't fight 
+	// over the same line.
+	alignas(64) std::atomic<size_t> write_index = 0;
+	alignas(64) std::atomic<size_t> read_index = 0;
+	T data[Size];
+};
+
+// Multiple producer, single consumer ring buffer. Each slot carries a sequence
+// number so producers can claim slots with a single compare and swap and the
+// consumer can tell when a claimed slot has actually been written.
+template<typename T, size_t Size>
+struct Mpsc_Ring_Buffer {
+	static_assert(Size > 0 && (Size & (Size - 1)) == 0, "Size must be a power of two.");
+
+	Mpsc_Ring_Buffer() {
+		for (size_t i = 0; i < Size; i++) {
+			this->slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	bool push(const T &value) {
+		size_t write_index = this->write_index.load(std::memory_order_relaxed);
+		Slot *slot;
+		while (true) {
+			slot = &this->slots[write_index & (Size - 1)];
+			const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+			const ptrdiff_t difference = (ptrdiff_t)sequence - (ptrdiff_t)write_index;
+			if (difference == 0) {
+				if (this->write_index.compare_exchange_weak(write_index, write_index + 1, std::memory_order_relaxed)) {
+					break;
+				}
+			} else if (difference < 0) {
+				return false;
+			} else {
+				write_index = this->write_index.load(std::memory_order_relaxed);
+			}
+		}
+
+		slot->value = value;
+		slot->sequence.store(write_index + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T *value) {
+		const size_t read_index = this->read_index.load(std::memory_order_relaxed);
+		Slot &slot = this->slots[read_index & (Size - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != read_index + 1) {
+			return false;
+		}
+
+		*value = slot.value;
+		slot.sequence.store(read_index + Size, std::memory_order_release);
+		this->read_index.store(read_index + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+private:
+	struct Slot {
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	alignas(64) std::atomic<size_t> write_index = 0;
+	alignas(64) std::atomic<size_t> read_index = 0;
+	Slot slots[Size];
+};
\ No newline at end of file
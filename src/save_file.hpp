@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "persistent_game_state.hpp"
+
+// Binary, little endian save record:
+//
+//   magic "FBSV", version, high score, games played, recent score count,
+//   recent scores, checksum of everything before it
+//
+// Bump `version` whenever the layout changes and keep `decode` able to read
+// the older versions.
+namespace Save_File {
+	const uint32_t magic = 'F' | 'B' << 8 | 'S' << 16 | 'V' << 24;
+	const uint32_t version = 1;
+
+	const size_t recent_score_capacity = std::tuple_size<decltype(Persistent_Game_State::recent_scores)>::value;
+	const size_t size = sizeof(uint32_t) * (6 + recent_score_capacity);
+
+	using Buffer = uint8_t[size];
+
+	inline void write_u32(uint8_t **cursor, uint32_t value) {
+		for (int i = 0; i < 4; i++) {
+			*(*cursor)++ = (uint8_t)(value >> (i * 8));
+		}
+	}
+
+	inline uint32_t read_u32(const uint8_t **cursor) {
+		uint32_t value = 0;
+		for (int i = 0; i < 4; i++) {
+			value |= (uint32_t)*(*cursor)++ << (i * 8);
+		}
+		return value;
+	}
+
+	// FNV-1a, only there to catch truncated or corrupt files.
+	inline uint32_t checksum(const uint8_t *data, size_t length) {
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < length; i++) {
+			hash = (hash ^ data[i]) * 16777619u;
+		}
+		return hash;
+	}
+
+	inline void encode(const Persistent_Game_State &state, Buffer &buffer) {
+		uint8_t *cursor = buffer;
+		write_u32(&cursor, magic);
+		write_u32(&cursor, version);
+		write_u32(&cursor, (uint32_t)state.high_score);
+		write_u32(&cursor, (uint32_t)state.games_played);
+		write_u32(&cursor, (uint32_t)state.recent_score_count);
+		for (int score : state.recent_scores) {
+			write_u32(&cursor, (uint32_t)score);
+		}
+		write_u32(&cursor, checksum(buffer, cursor - buffer));
+	}
+
+	inline bool decode(const uint8_t *data, size_t length, Persistent_Game_State *state) {
+		const uint8_t *cursor = data;
+		if (length < sizeof(uint32_t) * 2 || read_u32(&cursor) != magic) {
+			// Saves from before the binary format were the high score as text.
+			char text[16] = {};
+			for (size_t i = 0; i < length && i < sizeof(text) - 1; i++) {
+				text[i] = (char)data[i];
+			}
+
+			char *end;
+			const long high_score = strtol(text, &end, 10);
+			if (end == text) {
+				return false;
+			}
+
+			*state = {};
+			state->high_score = (int)high_score;
+			return true;
+		}
+
+		const uint32_t file_version = read_u32(&cursor);
+		if (file_version != version || length < size) {
+			return false;
+		}
+
+		const uint32_t expected_checksum = checksum(data, size - sizeof(uint32_t));
+
+		Persistent_Game_State loaded = {};
+		loaded.high_score = (int)read_u32(&cursor);
+		loaded.games_played = (int)read_u32(&cursor);
+		loaded.recent_score_count = (int)read_u32(&cursor);
+		for (int &score : loaded.recent_scores) {
+			score = (int)read_u32(&cursor);
+		}
+
+		if (read_u32(&cursor) != expected_checksum || loaded.recent_score_count > (int)recent_score_capacity) {
+			return false;
+		}
+
+		*state = loaded;
+		return true;
+	}
+};
\ No newline at end of file
@@ -1,124 +1,483 @@
 #pragma once
 
+#include <array>
+#include <cassert>
+#include <cmath>
 #include <string>
 
 #include <SDL2/SDL.h>
 
+#include "assets.hpp"
 #include "audio_player.hpp"
+#include "logger.hpp"
+#include "music_stream.hpp"
+#include "native_platform.hpp"
+#include "profiler.hpp"
+#include "ring_buffer.hpp"
+#include "simd.hpp"
 
-struct Audio {
-	SDL_AudioSpec spec;
-	Uint8 *buffer;
-	Uint32 length;
-	Uint32 current_position;
+// Clips are converted to the device format when loaded, so they are always
+// interleaved stereo floats at the device frequency.
+struct Audio_Clip {
+	float *samples;
+	Uint32 frame_count;
 };
 
-struct SDL_Audio_Player : Audio_Player {
-	Platform &platform;
+// A single playing instance of a clip. Voices are only ever touched by the
+// audio thread.
+struct Audio_Voice {
+	const Audio_Clip *clip = nullptr;
+	Uint32 position = 0;
+	float left_gain = 1.0f;
+	float right_gain = 1.0f;
+};
+
+struct Audio_Command {
+	Asset::Audio_ID audio_id;
+	float left_gain;
+	float right_gain;
+};
+
+struct SDL_Audio_Player {
+	static constexpr int channels = 2;
+	static constexpr int frequency = 48000;
+	static constexpr Uint16 buffer_frames = 512;
+
+	Native_Platform &platform;
+
+	// A WAV streamed as background music. There is no music when it is null.
+	const char *music_path = nullptr;
+
+	SDL_Audio_Player(Native_Platform &platform) : platform{platform} {}
 
-	SDL_Audio_Player(Platform &platform) : platform{platform} {}
+	// Closing the device waits for a callback in progress, so nothing reads
+	// the player once this returns.
+	~SDL_Audio_Player() {
+		if (this->device != 0) {
+			SDL_CloseAudioDevice(this->device);
+		}
+
+		delete this->music;
+
+		for (Audio_Clip &clip : this->clips) {
+			SDL_free(clip.samples);
+		}
+	}
 
 private:
-	Audio flap_audio;
-	Audio score_audio;
-	Audio hit_audio;
+	SDL_AudioDeviceID device = 0;
+	std::array<Audio_Clip, (size_t)Asset::Audio_ID::_length> clips = {};
+	std::array<Audio_Voice, 16> voices = {};
+
+	// Written by the game thread and drained by the audio thread at the start
+	// of every callback.
+	Spsc_Ring_Buffer<Audio_Command, 64> commands;
+
+	// Null when there is no music track, see `music_path`.
+	Music_Stream *music = nullptr;
+	const float music_gain = 0.5f;
+
+	// State for the null device, where there is no audio thread and mixing is
+	// driven by the game loop instead.
+	struct {
+		bool enabled = false;
+		SDL_RWops *wav_file = nullptr;
+		Uint32 frames_written = 0;
+		double pending_frames = 0.0;
+		Uint64 mix_ticks = 0;
+		Uint64 buffer_count = 0;
+		float buffer[buffer_frames * channels];
+	} offline;
 
 public:
 	bool init() {
-		const std::string flap_audio_path = this->platform.get_asset_path(Asset::get_audio(Asset::Audio_ID::flap));
-		bool success = this->load(flap_audio_path, &this->flap_audio);
-		if (!success) {
+		SDL_AudioSpec desired = {};
+		desired.freq = frequency;
+		desired.format = AUDIO_F32SYS;
+		desired.channels = channels;
+		desired.samples = buffer_frames;
+		desired.userdata = this;
+		desired.callback = audio_callback;
+
+		// No changes are allowed so SDL will convert to the hardware format for
+		// us and the callback can always assume float stereo.
+		SDL_AudioSpec obtained;
+		this->device = SDL_OpenAudioDevice(NULL, 0, &desired, &obtained, 0);
+		if (this->device == 0) {
+			LOG_ERROR("%s", SDL_GetError());
 			return false;
 		}
 
-		const std::string score_audio_path = this->platform.get_asset_path(Asset::get_audio(Asset::Audio_ID::score));
-		success = this->load(score_audio_path, &this->score_audio);
-		if (!success) {
+		if (!this->load_clips()) {
 			return false;
 		}
 
-		const std::string hit_audio_path = this->platform.get_asset_path(Asset::get_audio(Asset::Audio_ID::hit));
-		success = this->load(hit_audio_path, &this->hit_audio);
-		if (!success) {
+		this->open_music();
+
+		// Play all audio
+		SDL_PauseAudioDevice(this->device, 0);
+
+		return true;
+	}
+
+	// Runs the same mixing path as `init` without any sound hardware. Mixed 
+	// output is written to `wav_path` if it isn't null.
+	bool init_null(const char *wav_path) {
+		if (!this->load_clips()) {
 			return false;
 		}
 
-		// Use the flap audio spec as the desired audio spec, I don't thing it 
-		// matters too much what the spec is here.
-		SDL_AudioSpec desired = flap_audio.spec;
-		desired.userdata = this;
-		desired.callback = audio_callback;
+		this->open_music();
+
+		this->offline.enabled = true;
+
+		if (wav_path != nullptr) {
+			this->offline.wav_file = SDL_RWFromFile(wav_path, "wb");
+			if (this->offline.wav_file == nullptr) {
+				LOG_ERROR("%s", SDL_GetError());
+				return false;
+			}
 
-		// Only works if `obtained` is NULL. Not sure why.
-		if (SDL_OpenAudio(&desired, NULL) < 0) {
-			SDL_Log(SDL_GetError());
+			write_wav_header(this->offline.wav_file, 0);
+		}
+
+		return true;
+	}
+
+	bool is_null() const {
+		return this->offline.enabled;
+	}
+
+	// Advances the null device by `seconds` of simulation time, mixing every
+	// buffer that has become due. Sounds land in the output at the tick that
+	// triggered them, so renders are repeatable for the same inputs.
+	void render_offline(float seconds) {
+		assert(this->offline.enabled);
+
+		this->offline.pending_frames += seconds * frequency;
+		while (this->offline.pending_frames >= buffer_frames) {
+			this->offline.pending_frames -= buffer_frames;
+			this->mix_offline_buffer();
+		}
+	}
+
+	// Patches the WAV header and reports the average mixing cost.
+	void finish_offline_render() {
+		assert(this->offline.enabled);
+
+		if (this->offline.wav_file != nullptr) {
+			SDL_RWseek(this->offline.wav_file, 0, RW_SEEK_SET);
+			write_wav_header(this->offline.wav_file, this->offline.frames_written);
+			SDL_RWclose(this->offline.wav_file);
+			this->offline.wav_file = nullptr;
+		}
+
+		LOG_INFO(
+			"Audio: %llu buffers of %d frames, %.2f us per buffer",
+			(unsigned long long)this->offline.buffer_count, 
+			buffer_frames,
+			this->get_microseconds_per_buffer()
+		);
+	}
+
+	// Mixes `buffer_count` buffers on the null device while keeping
+	// `voice_count` voices playing, and reports the cost per buffer.
+	static bool benchmark(Native_Platform &platform, int voice_count, int buffer_count, const char *wav_path) {
+		SDL_Audio_Player player(platform);
+		if (!player.init_null(wav_path)) {
 			return false;
 		}
 
-		// Play all audio
-		SDL_PauseAudio(0);
+		voice_count = voice_count > (int)player.voices.size() ? (int)player.voices.size() : voice_count;
+
+		for (int buffer_i = 0; buffer_i < buffer_count; buffer_i++) {
+			int active_voice_count = 0;
+			for (const Audio_Voice &voice : player.voices) {
+				active_voice_count += voice.clip != nullptr;
+			}
+
+			// Spread the voices across the stereo field and the clips.
+			for (int voice_i = active_voice_count; voice_i < voice_count; voice_i++) {
+				const Asset::Audio_ID audio_id = static_cast<Asset::Audio_ID>(voice_i % (int)Asset::Audio_ID::_length);
+				const float pan = voice_count > 1 ? (float)voice_i / (voice_count - 1) * 2 - 1 : 0.0f;
+				player.play(audio_id, 1.0f / voice_count, pan);
+			}
+
+			player.mix_offline_buffer();
+		}
 
+		LOG_INFO("Audio benchmark: %d voices", voice_count);
+		player.finish_offline_render();
 		return true;
 	}
 
-	void flap() override {
-		this->play(&this->flap_audio);
+	void flap() {
+		this->play(Asset::Audio_ID::flap);
+	}
+
+	void score() {
+		this->play(Asset::Audio_ID::score);
 	}
 
-	void score() override {
-		this->play(&this->score_audio);
+	void hit() {
+		this->play(Asset::Audio_ID::hit);
 	}
 
-	void hit() override {
-		this->play(&this->hit_audio);
+	// `pan` goes from -1 (left) to 1 (right).
+	void play(Asset::Audio_ID audio_id, float gain = 1.0f, float pan = 0.0f) {
+		// Constant power panning, scaled so a centred voice plays at `gain` on
+		// both channels.
+		const float quarter_pi = 0.785398163f;
+		const float square_root_two = 1.414213562f;
+		const float angle = (pan + 1.0f) * quarter_pi;
+		const float scale = gain * square_root_two;
+
+		// If the queue is full the sound is dropped rather than blocking the
+		// game thread.
+		this->commands.push({
+			.audio_id = audio_id,
+			.left_gain = cosf(angle) * scale,
+			.right_gain = sinf(angle) * scale
+		});
 	}
 
 private:
-	bool load(std::string path, Audio *audio) {
-		SDL_AudioSpec *spec = SDL_LoadWAV(
-			path.c_str(), 
-			&audio->spec, 
-			&audio->buffer, 
-			&audio->length
+	bool load_clips() {
+		PROFILE_ZONE("Load audio clips");
+		for (size_t i = 0; i < this->clips.size(); i++) {
+			const Asset::Audio_ID audio_id = static_cast<Asset::Audio_ID>(i);
+			const std::string audio_path = this->platform.get_asset_path(Asset::get_audio(audio_id));
+			const bool success = this->load(audio_path, &this->clips[i]);
+			if (!success) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void open_music() {
+		if (this->music_path == nullptr) {
+			return;
+		}
+
+		PROFILE_ZONE("Open music");
+		this->music = new Music_Stream();
+		if (!this->music->open(this->music_path, channels, frequency)) {
+			LOG_INFO("No music will be played.");
+			delete this->music;
+			this->music = nullptr;
+		}
+	}
+
+	bool load(std::string path, Audio_Clip *clip) {
+		Platform_File *file;
+		this->platform.load_file(path.c_str(), &file);
+		if (file == nullptr) {
+			return false;
+		}
+
+		SDL_AudioSpec spec;
+		Uint8 *wav_buffer;
+		Uint32 wav_length;
+		SDL_RWops *wav_file = SDL_RWFromConstMem(file->contents, (int)file->content_size);
+		const SDL_AudioSpec *loaded_spec = SDL_LoadWAV_RW(wav_file, 1, &spec, &wav_buffer, &wav_length);
+		this->platform.close_file(&file);
+
+		if (loaded_spec == nullptr) {
+			LOG_ERROR("%s", SDL_GetError());
+			return false;
+		}
+
+		SDL_AudioCVT cvt;
+		const int result = SDL_BuildAudioCVT(
+			&cvt,
+			spec.format,
+			spec.channels,
+			spec.freq,
+			AUDIO_F32SYS,
+			channels,
+			frequency
 		);
 
-		if (spec == nullptr) {
-			SDL_Log(SDL_GetError());
+		if (result < 0) {
+			LOG_ERROR("%s", SDL_GetError());
+			SDL_FreeWAV(wav_buffer);
 			return false;
 		}
 
-		this->stop(audio);
+		cvt.len = wav_length;
+		cvt.buf = (Uint8 *)SDL_malloc(wav_length * cvt.len_mult);
+		SDL_memcpy(cvt.buf, wav_buffer, wav_length);
+		SDL_FreeWAV(wav_buffer);
+
+		if (SDL_ConvertAudio(&cvt) < 0) {
+			LOG_ERROR("%s", SDL_GetError());
+			SDL_free(cvt.buf);
+			return false;
+		}
+
+		clip->samples = (float *)cvt.buf;
+		clip->frame_count = cvt.len_cvt / (sizeof(float) * channels);
 		return true;
 	}
 
-	void play(Audio *audio) {
-		audio->current_position = 0;
+	void start_voice(const Audio_Command &command) {
+		// Take a free voice if there is one, otherwise steal the voice that has
+		// played the furthest through its clip.
+		Audio_Voice *chosen_voice = &this->voices[0];
+		for (Audio_Voice &voice : this->voices) {
+			if (voice.clip == nullptr) {
+				chosen_voice = &voice;
+				break;
+			}
+
+			if (voice.position > chosen_voice->position) {
+				chosen_voice = &voice;
+			}
+		}
+
+		chosen_voice->clip = &this->clips[(size_t)command.audio_id];
+		chosen_voice->position = 0;
+		chosen_voice->left_gain = command.left_gain;
+		chosen_voice->right_gain = command.right_gain;
+	}
+
+	static void mix_voice(float *stream, Uint32 frame_count, Audio_Voice *voice) {
+		const Audio_Clip *clip = voice->clip;
+		const Uint32 remaining_frames = clip->frame_count - voice->position;
+		const Uint32 frames = frame_count > remaining_frames ? remaining_frames : frame_count;
+		const float *source = clip->samples + voice->position * channels;
+		const Uint32 sample_count = frames * channels;
+
+		// Samples are interleaved left/right, so each vector holds two frames.
+		Uint32 i = 0;
+		#if SIMD_SSE
+		const __m128 gains = _mm_setr_ps(voice->left_gain, voice->right_gain, voice->left_gain, voice->right_gain);
+		for (; i + 4 <= sample_count; i += 4) {
+			const __m128 mixed = _mm_add_ps(_mm_loadu_ps(stream + i), _mm_mul_ps(_mm_loadu_ps(source + i), gains));
+			_mm_storeu_ps(stream + i, mixed);
+		}
+		#elif SIMD_NEON
+		const float gain_values[4] = { voice->left_gain, voice->right_gain, voice->left_gain, voice->right_gain };
+		const float32x4_t gains = vld1q_f32(gain_values);
+		for (; i + 4 <= sample_count; i += 4) {
+			vst1q_f32(stream + i, vmlaq_f32(vld1q_f32(stream + i), vld1q_f32(source + i), gains));
+		}
+		#endif
+
+		for (; i < sample_count; i += channels) {
+			stream[i] += source[i] * voice->left_gain;
+			stream[i + 1] += source[i + 1] * voice->right_gain;
+		}
+
+		voice->position += frames;
+		if (voice->position >= clip->frame_count) {
+			voice->clip = nullptr;
+		}
 	}
 
-	void stop(Audio *audio) {
-		audio->current_position = audio->length;
+	// Rational approximation of tanh. It is close to linear for quiet signals
+	// and saturates smoothly towards -1 and 1 when many voices overlap.
+	static void soft_clip(float *stream, Uint32 sample_count) {
+		Uint32 i = 0;
+		#if SIMD_SSE
+		const __m128 limit = _mm_set1_ps(3.0f);
+		const __m128 negative_limit = _mm_set1_ps(-3.0f);
+		const __m128 twenty_seven = _mm_set1_ps(27.0f);
+		const __m128 nine = _mm_set1_ps(9.0f);
+		for (; i + 4 <= sample_count; i += 4) {
+			const __m128 x = _mm_max_ps(negative_limit, _mm_min_ps(limit, _mm_loadu_ps(stream + i)));
+			const __m128 x2 = _mm_mul_ps(x, x);
+			const __m128 numerator = _mm_mul_ps(x, _mm_add_ps(twenty_seven, x2));
+			const __m128 denominator = _mm_add_ps(twenty_seven, _mm_mul_ps(nine, x2));
+			_mm_storeu_ps(stream + i, _mm_div_ps(numerator, denominator));
+		}
+		#elif SIMD_NEON
+		for (; i + 4 <= sample_count; i += 4) {
+			const float32x4_t x = vmaxq_f32(vdupq_n_f32(-3.0f), vminq_f32(vdupq_n_f32(3.0f), vld1q_f32(stream + i)));
+			const float32x4_t x2 = vmulq_f32(x, x);
+			const float32x4_t numerator = vmulq_f32(x, vaddq_f32(vdupq_n_f32(27.0f), x2));
+			const float32x4_t denominator = vmlaq_f32(vdupq_n_f32(27.0f), vdupq_n_f32(9.0f), x2);
+			vst1q_f32(stream + i, vdivq_f32(numerator, denominator));
+		}
+		#endif
+
+		for (; i < sample_count; i++) {
+			const float x = fmaxf(-3.0f, fminf(3.0f, stream[i]));
+			stream[i] = x * (27.0f + x * x) / (27.0f + 9.0f * x * x);
+		}
 	}
 
-	static void mix_audio(Uint8 *stream, int stream_length, Audio *audio) {
-		const Uint8 *buffer_start_position = audio->buffer + audio->current_position;
-		const Uint32 remaining_sound_length = audio->length - audio->current_position;
-		const Uint32 length = stream_length > remaining_sound_length ? remaining_sound_length : stream_length;
-		SDL_MixAudio(stream, buffer_start_position, length, SDL_MIX_MAXVOLUME);
-		audio->current_position += length;
+	void mix(float *samples, Uint32 frame_count) {
+		SDL_memset(samples, 0, frame_count * channels * sizeof(float));
+
+		Audio_Command command;
+		while (this->commands.pop(&command)) {
+			this->start_voice(command);
+		}
+
+		for (Audio_Voice &voice : this->voices) {
+			if (voice.clip != nullptr) {
+				mix_voice(samples, frame_count, &voice);
+			}
+		}
+
+		if (this->music != nullptr) {
+			this->music->mix(samples, frame_count * channels, this->music_gain);
+		}
+
+		soft_clip(samples, frame_count * channels);
 	}
 
 	static void audio_callback(void *data, Uint8 *stream, int stream_length) {
-		SDL_AudioSpec device_spec;
-		SDL_GetAudioDeviceSpec(NULL, 0, &device_spec);
-		SDL_memset(stream, device_spec.silence, stream_length);
-
 		if (stream_length == 0) {
 			return;
 		}
-	
+
 		SDL_Audio_Player *player = (SDL_Audio_Player*)data;
-		mix_audio(stream, stream_length, &player->flap_audio);
-		mix_audio(stream, stream_length, &player->score_audio);
-		mix_audio(stream, stream_length, &player->hit_audio);
+		player->mix((float *)stream, stream_length / (sizeof(float) * channels));
+	}
+
+	void mix_offline_buffer() {
+		const Uint64 start = SDL_GetPerformanceCounter();
+		this->mix(this->offline.buffer, buffer_frames);
+		this->offline.mix_ticks += SDL_GetPerformanceCounter() - start;
+		this->offline.buffer_count++;
+
+		if (this->offline.wav_file != nullptr) {
+			SDL_RWwrite(this->offline.wav_file, this->offline.buffer, sizeof(float) * channels, buffer_frames);
+			this->offline.frames_written += buffer_frames;
+		}
+	}
+
+	float get_microseconds_per_buffer() const {
+		if (this->offline.buffer_count == 0) {
+			return 0.0f;
+		}
+
+		const double seconds = (double)this->offline.mix_ticks / SDL_GetPerformanceFrequency();
+		return (float)(seconds * 1000000 / this->offline.buffer_count);
 	}
-};
\ No newline at end of file
+
+	// 32 bit float WAV header. Sizes are written as zero and patched when the
+	// render finishes.
+	static void write_wav_header(SDL_RWops *file, Uint32 frame_count) {
+		const Uint32 data_size = frame_count * channels * sizeof(float);
+		SDL_RWwrite(file, "RIFF", 4, 1);
+		SDL_WriteLE32(file, 36 + data_size);
+		SDL_RWwrite(file, "WAVE", 4, 1);
+		SDL_RWwrite(file, "fmt ", 4, 1);
+		SDL_WriteLE32(file, 16);
+		SDL_WriteLE16(file, 3); // IEEE float
+		SDL_WriteLE16(file, channels);
+		SDL_WriteLE32(file, frequency);
+		SDL_WriteLE32(file, frequency * channels * sizeof(float));
+		SDL_WriteLE16(file, channels * sizeof(float));
+		SDL_WriteLE16(file, sizeof(float) * 8);
+		SDL_RWwrite(file, "data", 4, 1);
+		SDL_WriteLE32(file, data_size);
+	}
+};
+
+static_assert(Audio_Backend<SDL_Audio_Player>);
\ No newline at end of file
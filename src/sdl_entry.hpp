@@ -3,28 +3,53 @@
 #include <SDL2/SDL.h>
 #include <glm/glm.hpp>
 #include <GL/glew.h>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 
+#include "allocation_tracker.hpp"
 #include "application.hpp"
+#include "arena.hpp"
+#include "asset_loader.hpp"
 #include "game.hpp"
+#include "game_rules.hpp"
 #include "persistent_game_state.hpp"
 #include "game_state.hpp"
 #include "gl_renderer.hpp"
 #include "input.hpp"
-#include "sdl_platform.hpp"
+#include "logger.hpp"
+#include "native_platform.hpp"
+#include "performance_overlay.hpp"
+#include "profiler.hpp"
 #include "debug_state.hpp"
 #include "sdl_audio_player.hpp"
+#include "simulation.hpp"
+#include "tuning.hpp"
+
+// Everything lives in one reservation made at startup. The persistent arena
+// holds the subsystems for the life of the program and the frame arena is
+// cleared at the start of every frame.
+static constexpr size_t persistent_arena_size = 8 * 1024 * 1024;
+static constexpr size_t frame_arena_size = 1024 * 1024;
+static void *reservation = nullptr;
+static Arena persistent_arena;
+static Arena frame_arena;
 
 static GL_Renderer *renderer = nullptr;
 static Application *application = nullptr;
-static SDL_Platform *platform = nullptr;
+static Native_Platform *platform = nullptr;
 static Persistent_Game_State *persistent_game_state = nullptr;
 static Game_State *game_state = nullptr;
 static Game_State *previous_game_state = nullptr;
 static Debug_State *debug_state = nullptr;
+static Performance_Overlay *performance_overlay = nullptr;
 static Input *input = nullptr;
 static SDL_Audio_Player *audio_player = nullptr;
+using Game_Simulation = Simulation<Native_Platform, SDL_Audio_Player>;
+using Headless_Simulation = Simulation<Null_Storage, Null_Audio_Player>;
+
+static Game_Simulation *simulation = nullptr;
 
 void debug_message_handle(
 	GLenum source,
@@ -35,16 +60,253 @@ void debug_message_handle(
 	const GLchar *message,
 	const void *user_param
 ) {
+	// Can be called from inside the driver, so this only ever queues the
+	// message.
 	if (type == GL_DEBUG_TYPE_ERROR) {
-		platform->log_error("GL Error: Severity: %i, Message: %s", severity, message);
+		LOG_ERROR("GL Error: Severity: %i, Message: %s", severity, message);
+	} else {
+		LOG_DEBUG("GL Debug Message: %s", message);
+	}
+}
+
+void log_sink(Log_Level level, const char *message) {
+	if (level == Log_Level::error) {
+		platform->log_error("%s", message);
+	} else {
+		platform->log_info("%s", message);
+	}
+}
+
+// Once the logger has stopped, anything it had no room to queue is reported
+// straight through the platform.
+void stop_logger() {
+	global_logger.stop();
+
+	const uint64_t dropped_count = global_logger.get_dropped_count();
+	if (dropped_count > 0) {
+		platform->log_error("Dropped %llu log records, the queue was full.", (unsigned long long)dropped_count);
+	}
+}
+
+void write_trace(const char *path) {
+	if (Profiler::write_chrome_trace(path)) {
+		LOG_INFO("Wrote trace (%s).", path);
 	} else {
-		platform->log_info("GL Debug Message: %s", message);
+		LOG_ERROR("Could not write trace (%s).", path);
+	}
+}
+
+void log_telemetry(const Game_Telemetry &telemetry) {
+	LOG_INFO(
+		"Played %u runs: %u flaps, %u points, %u hits, %u new high scores",
+		telemetry.run_count,
+		telemetry.flap_count,
+		telemetry.score_count,
+		telemetry.hit_count,
+		telemetry.new_high_score_count
+	);
+}
+
+// Plays `tick_count` ticks as fast as they run, with no window, audio or
+// saves, then logs how the runs went. For checking rules and tuning in bulk.
+bool run_headless(Game_Variant game_variant, const char *tuning_path, uint64_t tick_count) {
+	if (!Asset_Loader::load_simulation_assets(*platform)) {
+		return false;
+	}
+
+	if (tuning_path != nullptr && !Tuning_Profile::load(tuning_path, &Tuned_Rules::tuning)) {
+		return false;
+	}
+
+	game_state = persistent_arena.make<Game_State>();
+	visit_game_rules(game_variant, [&](auto rules) {
+		Game<decltype(rules)>::setup(game_state);
+	});
+
+	Null_Storage *storage = persistent_arena.make<Null_Storage>();
+	Null_Audio_Player *null_audio_player = persistent_arena.make<Null_Audio_Player>();
+
+	Headless_Simulation *headless_simulation = persistent_arena.make<Headless_Simulation>();
+	headless_simulation->game_state = game_state;
+	headless_simulation->previous_game_state = persistent_arena.make<Game_State>();
+	headless_simulation->input = persistent_arena.make<Input>();
+	headless_simulation->persistent_game_state = persistent_arena.make<Persistent_Game_State>();
+	headless_simulation->debug_state = nullptr;
+	headless_simulation->storage = storage;
+	headless_simulation->audio_player = null_audio_player;
+	headless_simulation->platform = platform;
+	headless_simulation->game_variant = game_variant;
+
+	const uint64_t start_ns = platform->get_monotonic_time_ns();
+	headless_simulation->run_headless(tick_count);
+	const uint64_t elapsed_ns = platform->get_monotonic_time_ns() - start_ns;
+
+	LOG_INFO(
+		"Headless: %u ticks in %.1f ms, high score %i",
+		tick_count,
+		elapsed_ns / 1e6,
+		headless_simulation->persistent_game_state->high_score
+	);
+	log_telemetry(headless_simulation->telemetry);
+
+	headless_simulation->~Headless_Simulation();
+	return true;
+}
+
+// Hands clicks to the simulation and applies the window and debug keys.
+static void pump_events(SDL_Window *window, const char *trace_path, bool *should_close) {
+	PROFILE_ZONE("Event pump");
+
+	// SDL event timestamps are in SDL ticks, so they are converted to the
+	// platform clock relative to when the events were pumped.
+	const uint64_t pump_time_ns = platform->get_monotonic_time_ns();
+	const Uint32 pump_ticks = SDL_GetTicks();
+
+	SDL_Event event;
+	while (SDL_PollEvent(&event)) {
+		if (event.type == SDL_EventType::SDL_KEYDOWN) {
+			switch (event.key.keysym.sym) {
+				#ifndef NDEBUG
+				case SDLK_MINUS: {
+					const float sim_speed = debug_state->sim_speed;
+					debug_state->sim_speed = fmaxf(0.0f, sim_speed - (sim_speed <= 1.0f ? 0.1f : 1.0f));
+				} break;
+
+				case SDLK_EQUALS: {
+					const float sim_speed = debug_state->sim_speed;
+					debug_state->sim_speed = fminf(255, sim_speed + (sim_speed < 1.0f ? 0.1f : 1.0f));
+				} break;
+
+				case SDLK_d: {
+					debug_state->show_collision_debugger = !debug_state->show_collision_debugger;
+				} break;
+
+				case SDLK_p: {
+					debug_state->show_performance_overlay = !debug_state->show_performance_overlay;
+				} break;
+
+				case SDLK_c: {
+					debug_state->clear_high_score = true;
+				} break;
+
+				case SDLK_t: {
+					write_trace(trace_path != nullptr ? trace_path : "trace.json");
+				} break;
+				#endif
+
+				case SDLK_F11: {
+					const bool is_fullscreen = SDL_GetWindowFlags(window) & SDL_WINDOW_FULLSCREEN_DESKTOP;
+					if (is_fullscreen) {
+						SDL_SetWindowResizable(window, SDL_TRUE);
+						SDL_SetWindowFullscreen(window, 0);
+					} else {
+						SDL_SetWindowFullscreen(window, SDL_WINDOW_FULLSCREEN_DESKTOP);
+					}
+				} break;
+			}
+		} else if (
+			event.type == SDL_EventType::SDL_MOUSEBUTTONDOWN || 
+			event.type == SDL_EventType::SDL_MOUSEBUTTONUP
+		) {
+			if (event.button.button == 1) {
+				const Uint32 age_ms = pump_ticks - event.button.timestamp;
+				const uint64_t age_ns = (uint64_t)age_ms * 1000000;
+				simulation->input_events.push({
+					.type = event.type == SDL_EventType::SDL_MOUSEBUTTONDOWN ? Input_Event::Type::down : Input_Event::Type::up,
+					.time_ns = age_ns < pump_time_ns ? pump_time_ns - age_ns : 0
+				});
+			}
+		} else if (event.type == SDL_EventType::SDL_QUIT) {
+			*should_close = true;
+		} else if (
+			event.type == SDL_EventType::SDL_WINDOWEVENT && 
+			event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED
+		) {
+			application->window.width = event.window.data1;
+			application->window.height = event.window.data2;
+		}
 	}
 }
 
 // Must have the main standard arguments for SDL to work.
 int main(int argc, char *args[]) {
-	int success = SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
+	// `--null-audio <path>` mixes audio without a device and writes it to a WAV.
+	// `--audio-benchmark <voices>` measures the mixer and exits.
+	// `--rules <classic|hard|training|tuned>` picks the variant to play. Tuned
+	// plays classic, but reads its rules at run time.
+	// `--tuning <path>` plays tuned with the rules in a tuning profile, which
+	// debug builds reload whenever it changes. It overrides `--rules`.
+	// `--trace <path>` writes a Chrome trace of the latest zones on exit.
+	// `--music <path>` streams a WAV as background music. There is none
+	// without it.
+	// `--headless <ticks>` plays that many ticks without a window or audio,
+	// logs the results and exits.
+	const char *null_audio_path = nullptr;
+	const char *music_path = nullptr;
+	const char *tuning_path = nullptr;
+	const char *trace_path = nullptr;
+	int audio_benchmark_voices = 0;
+	uint64_t headless_tick_count = 0;
+	Game_Variant game_variant = Game_Variant::classic;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(args[i], "--null-audio") == 0 && i + 1 < argc) {
+			null_audio_path = args[++i];
+		} else if (strcmp(args[i], "--audio-benchmark") == 0 && i + 1 < argc) {
+			audio_benchmark_voices = atoi(args[++i]);
+		} else if (strcmp(args[i], "--rules") == 0 && i + 1 < argc) {
+			if (!parse_game_variant(args[++i], &game_variant)) {
+				SDL_Log("Unknown rules (%s), playing classic.", args[i]);
+			}
+		} else if (strcmp(args[i], "--headless") == 0 && i + 1 < argc) {
+			headless_tick_count = strtoull(args[++i], nullptr, 10);
+		} else if (strcmp(args[i], "--music") == 0 && i + 1 < argc) {
+			music_path = args[++i];
+		} else if (strcmp(args[i], "--trace") == 0 && i + 1 < argc) {
+			trace_path = args[++i];
+		} else if (strcmp(args[i], "--tuning") == 0 && i + 1 < argc) {
+			tuning_path = args[++i];
+		}
+	}
+
+	if (tuning_path != nullptr) {
+		if (game_variant != Game_Variant::classic && game_variant != Game_Variant::tuned) {
+			SDL_Log("A tuning profile is given, playing tuned rather than the chosen rules.");
+		}
+		game_variant = Game_Variant::tuned;
+	}
+
+	PROFILE_THREAD("Main");
+
+	reservation = malloc(persistent_arena_size + frame_arena_size);
+	if (reservation == nullptr) {
+		SDL_Log("Could not reserve memory.");
+		return -1;
+	}
+	persistent_arena.init(reservation, persistent_arena_size);
+	frame_arena.init((uint8_t *)reservation + persistent_arena_size, frame_arena_size);
+
+	if (audio_benchmark_voices > 0) {
+		platform = persistent_arena.make<Native_Platform>();
+		global_logger.start(log_sink);
+		const bool benchmark_success = SDL_Audio_Player::benchmark(*platform, audio_benchmark_voices, 1000, null_audio_path);
+		stop_logger();
+		platform->~Native_Platform();
+		free(reservation);
+		return benchmark_success ? 0 : -1;
+	}
+
+	if (headless_tick_count > 0) {
+		platform = persistent_arena.make<Native_Platform>();
+		global_logger.start(log_sink);
+		const bool headless_success = run_headless(game_variant, tuning_path, headless_tick_count);
+		stop_logger();
+		platform->~Native_Platform();
+		free(reservation);
+		return headless_success ? 0 : -1;
+	}
+
+	const Uint32 init_flags = null_audio_path != nullptr ? SDL_INIT_VIDEO : SDL_INIT_VIDEO | SDL_INIT_AUDIO;
+	int success = SDL_Init(init_flags);
 	if (success != 0) {
 		SDL_Log(SDL_GetError());
 		return -1;
@@ -97,128 +359,214 @@ int main(int argc, char *args[]) {
 		return -1;
 	}
 
-	application = new Application();
+	application = persistent_arena.make<Application>();
 	application->window = { 
 		.width = display_bounds.w, 
 		.height = display_bounds.h 
 	};
 
-	platform = new SDL_Platform();
+	platform = persistent_arena.make<Native_Platform>();
+	global_logger.start(log_sink);
+
+	if (!Asset_Loader::load_simulation_assets(*platform)) {
+		return -1;
+	}
 
-	renderer = new GL_Renderer(*application, *platform);
+	renderer = persistent_arena.make<GL_Renderer>(*application, *platform, frame_arena);
 	success = renderer->init(debug_message_handle); 
 	if (!success) {
 		return -1;
 	}
 
 	// Initialise audio
-	audio_player = new SDL_Audio_Player(*platform);
-	audio_player->init();
+	audio_player = persistent_arena.make<SDL_Audio_Player>(*platform);
+	audio_player->music_path = music_path;
+	if (null_audio_path != nullptr) {
+		success = audio_player->init_null(null_audio_path);
+		if (!success) {
+			return -1;
+		}
+	} else {
+		audio_player->init();
+	}
+
+	// A profile that can't be read leaves the classic values in place. In
+	// debug builds it is still watched, so fixing it takes effect.
+	if (tuning_path != nullptr) {
+		Tuning_Profile::load(tuning_path, &Tuned_Rules::tuning);
+	}
 
 	// Initialise game states
-	game_state = new Game_State();
-	Game::setup(game_state);
+	game_state = persistent_arena.make<Game_State>();
+	visit_game_rules(game_variant, [&](auto rules) {
+		Game<decltype(rules)>::setup(game_state);
+	});
 
-	previous_game_state = new Game_State();
+	previous_game_state = persistent_arena.make<Game_State>();
 
 	#ifndef NDEBUG
-	debug_state = new Debug_State();
+	debug_state = persistent_arena.make<Debug_State>();
+	performance_overlay = persistent_arena.make<Performance_Overlay>();
 	#endif
 
-	input = new Input();
+	input = persistent_arena.make<Input>();
+
+	persistent_game_state = persistent_arena.make<Persistent_Game_State>();
+	platform->load(persistent_game_state);
+
+	simulation = persistent_arena.make<Game_Simulation>();
+	simulation->game_state = game_state;
+	simulation->previous_game_state = previous_game_state;
+	simulation->input = input;
+	simulation->persistent_game_state = persistent_game_state;
+	simulation->debug_state = debug_state;
+	simulation->storage = platform;
+	simulation->audio_player = audio_player;
+	simulation->platform = platform;
+	simulation->game_variant = game_variant;
+	if (tuning_path != nullptr) {
+		simulation->tuning_watcher.watch(tuning_path);
+	}
+	if (!simulation->start()) {
+		return -1;
+	}
 
-	persistent_game_state = new Persistent_Game_State();
-	persistent_game_state->high_score = platform->get_high_score();
+	bool should_close = false;
+	uint64_t uploaded_tick_count = UINT64_MAX;
 
-	Uint64 previous_time = SDL_GetTicks64();
-	float time_accumulator = 0;
+	// For the frame stats, only kept in debug builds.
+	uint64_t stats_tick_count = 0;
+	uint64_t stats_sim_time_ns = 0;
+	uint64_t previous_frame_end_ns = platform->get_monotonic_time_ns();
 
-	bool should_close = false;
+	// Not asserted on like the simulation's ticks, as the GL driver and SDL
+	// are free to allocate on this thread.
+	Allocation_Report frame_allocations;
 	while (!should_close) {
-		SDL_Event event;
-		while (SDL_PollEvent(&event)) {
-			if (event.type == SDL_EventType::SDL_KEYDOWN) {
-				switch (event.key.keysym.sym) {
-					#ifndef NDEBUG
-					case SDLK_MINUS: {
-						debug_state->sim_speed -= debug_state->sim_speed <= 1.0f ? 0.1f : 1.0f;
-						debug_state->sim_speed = fmaxf(0.0f, debug_state->sim_speed);
-					} break;
-
-					case SDLK_EQUALS: {
-						debug_state->sim_speed += debug_state->sim_speed < 1.0f ? 0.1f : 1.0f;
-						debug_state->sim_speed = fminf(255, debug_state->sim_speed);
-					} break;
-
-					case SDLK_d: {
-						debug_state->show_collision_debugger = !debug_state->show_collision_debugger;
-					} break;
-
-					case SDLK_c: {
-						persistent_game_state->high_score = 0;
-						platform->save_high_score(0);
-					} break;
-					#endif
-
-					case SDLK_F11: {
-						const bool is_fullscreen = SDL_GetWindowFlags(window) & SDL_WINDOW_FULLSCREEN_DESKTOP;
-						if (is_fullscreen) {
-							SDL_SetWindowResizable(window, SDL_TRUE);
-							SDL_SetWindowFullscreen(window, 0);
-						} else {
-							SDL_SetWindowFullscreen(window, SDL_WINDOW_FULLSCREEN_DESKTOP);
-						}
-					} break;
-				}
-			} else if (event.type == SDL_EventType::SDL_MOUSEBUTTONDOWN) {
-				if (event.button.button == 1) {
-					input->input_down();
-				}
-			} else if (event.type == SDL_EventType::SDL_MOUSEBUTTONUP) {
-				if (event.button.button == 1) {
-					input->input_up();
-				}
-			} else if (event.type == SDL_EventType::SDL_QUIT) {
-				should_close = true;
-			} else if (
-				event.type == SDL_EventType::SDL_WINDOWEVENT && 
-				event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED
-			) {
-				application->window.width = event.window.data1;
-				application->window.height = event.window.data2;
-			}
+		PROFILE_ZONE("Frame");
+		const uint64_t allocations_before = Allocation_Tracker::get_thread_count();
+		frame_arena.reset();
+
+		pump_events(window, trace_path, &should_close);
+
+		// Sprites only go to the GPU when a new tick has been published, frames
+		// in between just move the blend between the previous and current poses.
+		const Simulation_Snapshot &snapshot = simulation->snapshots.read();
+
+		// Built from the frames before this one.
+		const Performance_Overlay *shown_overlay = nullptr;
+		if (debug_state != nullptr && debug_state->show_performance_overlay) {
+			PROFILE_ZONE("Performance_Overlay::build");
+			performance_overlay->build(debug_state->frame_stats);
+			shown_overlay = performance_overlay;
 		}
 
-		const Uint64 current_time = SDL_GetTicks64();
-
-		if (debug_state != nullptr) {
-			time_accumulator += (current_time - previous_time) * debug_state->sim_speed;
-		} else {
-			time_accumulator += current_time - previous_time;
+		const uint64_t render_start_ns = platform->get_monotonic_time_ns();
+		if (snapshot.tick_count != uploaded_tick_count) {
+			PROFILE_ZONE("GL_Renderer::upload_sprites");
+			renderer->upload_sprites(snapshot.sprites);
+			uploaded_tick_count = snapshot.tick_count;
 		}
 
-		previous_time = current_time;
-
-		while (time_accumulator >= Game_Properties::sim_time_ms) {
-			*previous_game_state = *game_state;
-			time_accumulator -= Game_Properties::sim_time_ms;
-			Game::update(
-				game_state, 
-				input, 
-				persistent_game_state, 
-				debug_state, 
-				platform,
-				audio_player, 
-				Game_Properties::sim_time_s
+		{
+			PROFILE_ZONE("GL_Renderer::render");
+			const float alpha = snapshot.get_alpha(platform->get_monotonic_time_ns());
+			renderer->render(
+				snapshot.current,
+				alpha,
+				snapshot.has_debug_shapes ? &snapshot.debug_shapes : nullptr,
+				shown_overlay
 			);
 		}
+		const uint64_t render_end_ns = platform->get_monotonic_time_ns();
 
-		const float alpha = time_accumulator / Game_Properties::sim_time_ms;
-		Game::populate_sprites(game_state, previous_game_state, alpha);
+		{
+			PROFILE_ZONE("SDL_GL_SwapWindow");
+			SDL_GL_SwapWindow(window);
+		}
+
+		// Render time is what it took to submit the frame, the GPU's own time
+		// shows up in the swap and so in the frame time.
+		if (debug_state != nullptr) {
+			const uint64_t frame_end_ns = platform->get_monotonic_time_ns();
+			const uint64_t sim_time_ns = debug_state->sim_time_ns.load(std::memory_order_relaxed);
+			debug_state->frame_stats.record({
+				.frame_ns = frame_end_ns - previous_frame_end_ns,
+				.sim_ns = sim_time_ns - stats_sim_time_ns,
+				.render_ns = render_end_ns - render_start_ns - renderer->overlay_time_ns,
+				.tick_count = (uint32_t)(snapshot.tick_count - stats_tick_count),
+				.draw_call_count = renderer->draw_call_count
+			});
+			previous_frame_end_ns = frame_end_ns;
+			stats_sim_time_ns = sim_time_ns;
+			stats_tick_count = snapshot.tick_count;
+		}
+
+		frame_allocations.record(Allocation_Tracker::get_thread_count() - allocations_before);
+	}
+
+	simulation->stop();
+
+	if (audio_player->is_null()) {
+		audio_player->finish_offline_render();
+	}
+
+	LOG_INFO(
+		"Input to flap latency over %u flaps: p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms",
+		simulation->flap_latency.count,
+		simulation->flap_latency.get_percentile_ns(0.5f) / 1e6,
+		simulation->flap_latency.get_percentile_ns(0.9f) / 1e6,
+		simulation->flap_latency.get_percentile_ns(0.99f) / 1e6,
+		simulation->flap_latency.max_ns / 1e6
+	);
+
+	LOG_INFO(
+		"Simulated %u ticks: %u caught up after a late frame, %u dropped after a stall",
+		simulation->game_clock.tick_count,
+		simulation->game_clock.caught_up_tick_count,
+		simulation->game_clock.dropped_tick_count
+	);
+
+	log_telemetry(simulation->telemetry);
+
+	if (Allocation_Tracker::is_enabled) {
+		LOG_INFO(
+			"Heap allocations: %u over %u ticks (max %u per tick), %u over %u frames (%u frames allocated, max %u per frame)",
+			simulation->tick_allocations.allocation_count,
+			simulation->tick_allocations.frame_count,
+			simulation->tick_allocations.max_per_frame,
+			frame_allocations.allocation_count,
+			frame_allocations.frame_count,
+			frame_allocations.frames_with_allocations,
+			frame_allocations.max_per_frame
+		);
+	}
 
-		renderer->render(*game_state, debug_state);
-		SDL_GL_SwapWindow(window);
+	LOG_INFO(
+		"Arena high water: persistent %u of %u bytes, frame %u of %u bytes",
+		persistent_arena.high_water,
+		persistent_arena.capacity,
+		frame_arena.high_water,
+		frame_arena.capacity
+	);
+
+	if (trace_path != nullptr) {
+		write_trace(trace_path);
 	}
 
+	stop_logger();
+
+	// The arenas never run destructors, so everything owning a thread or a
+	// device is torn down by hand, newest first. The platform waits for any
+	// queued save to reach the disk.
+	simulation->~Game_Simulation();
+	audio_player->~SDL_Audio_Player();
+	platform->~Native_Platform();
+
+	SDL_GL_DeleteContext(gl_context);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
+	free(reservation);
+
 	return 0;
 }
\ No newline at end of file
@@ -1,86 +1,202 @@
 #pragma once
 
+#include <cstdarg>
+#include <cstdio>
 #include <cstdlib>
 #include <string>
 
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 #include <SDL2/SDL.h>
 
+#include "persistent_game_state.hpp"
 #include "platform.hpp"
+#include "save_file.hpp"
 
 struct _SDL_Platform_File : Platform_File {
 	SDL_RWops *file;
 };
 
-struct SDL_Platform : Platform {
+struct SDL_Platform {
 private:
-	SDL_RWops *save_file;
+	std::string base_path;
+	std::string save_file_path;
+	std::string save_temp_file_path;
+
+	// Saves are handed to a background thread. Only the latest requested
+	// state is kept, older pending saves are simply replaced.
+	SDL_Thread *save_thread;
+	SDL_mutex *save_mutex;
+	SDL_cond *save_condition;
+	Persistent_Game_State pending_save;
+	bool has_pending_save = false;
+	bool is_closing = false;
 
 public:
 	SDL_Platform() {
-		std::string user_path = SDL_GetPrefPath("Shy Zone", "Flappy Bird");
-		std::string save_file_path = user_path + "save";
-		this->save_file = SDL_RWFromFile(save_file_path.c_str(), "r+");
-		if (this->save_file == nullptr) {
-			this->save_file = SDL_RWFromFile(save_file_path.c_str(), "w+");
-		}
+		char *user_path = SDL_GetPrefPath("Shy Zone", "Flappy Bird");
+		this->save_file_path = std::string(user_path) + "save";
+		this->save_temp_file_path = this->save_file_path + ".tmp";
+		SDL_free(user_path);
+
+		char *base_path = SDL_GetBasePath();
+		this->base_path = base_path != nullptr ? base_path : "";
+		SDL_free(base_path);
+
+		this->save_mutex = SDL_CreateMutex();
+		this->save_condition = SDL_CreateCond();
+		this->save_thread = SDL_CreateThread(save_thread_main, "Save", this);
 	}
 
 	~SDL_Platform() {
-		SDL_RWclose(this->save_file);
+		// Let any pending save finish before exiting.
+		SDL_LockMutex(this->save_mutex);
+		this->is_closing = true;
+		SDL_CondSignal(this->save_condition);
+		SDL_UnlockMutex(this->save_mutex);
+
+		SDL_WaitThread(this->save_thread, NULL);
+		SDL_DestroyCond(this->save_condition);
+		SDL_DestroyMutex(this->save_mutex);
 	}
 
-	void log_error(const char *format, ...) const override {
+	void log_error(const char *format, ...) const {
 		va_list args;
 		va_start(args, format);
 		SDL_LogMessageV(SDL_LOG_CATEGORY_APPLICATION, SDL_LogPriority::SDL_LOG_PRIORITY_ERROR, format, args);
 		va_end(args);
 	}
 
-	void log_info(const char *format, ...) const override {
+	void log_info(const char *format, ...) const {
 		va_list args;
 		va_start(args, format);
 		SDL_LogMessageV(SDL_LOG_CATEGORY_APPLICATION, SDL_LogPriority::SDL_LOG_PRIORITY_INFO, format, args);
 		va_end(args);
 	}
 
-	void save_high_score(int score) const override {
-		char buffer[128] = {};
-		_itoa_s(score, buffer, 10);
-		SDL_RWseek(this->save_file, 0, RW_SEEK_SET);
-		SDL_RWwrite(this->save_file, buffer, sizeof(buffer), 1);
+	void save(const Persistent_Game_State &state) {
+		SDL_LockMutex(this->save_mutex);
+		this->pending_save = state;
+		this->has_pending_save = true;
+		SDL_CondSignal(this->save_condition);
+		SDL_UnlockMutex(this->save_mutex);
 	}
 
-	int get_high_score() const override {
-		const Sint64 file_size = SDL_RWsize(this->save_file);
-		char *contents = (char *)malloc(sizeof(char) * (file_size + 1));
-		SDL_RWread(this->save_file, contents, sizeof(char), file_size);
-		return _atoi64(contents);
+	void load(Persistent_Game_State *state) const {
+		*state = {};
+
+		SDL_RWops *file = SDL_RWFromFile(this->save_file_path.c_str(), "rb");
+		if (file == nullptr) {
+			return;
+		}
+
+		Save_File::Buffer buffer = {};
+		const size_t length = SDL_RWread(file, buffer, 1, sizeof(buffer));
+		SDL_RWclose(file);
+
+		if (!Save_File::decode(buffer, length, state)) {
+			this->log_error("Save file (%s) could not be read, starting fresh.", this->save_file_path.c_str());
+		}
 	}
 
-	void load_file(const char *path, Platform_File **file) const override {
+	void load_file(const char *path, Platform_File **file) const {
+		SDL_RWops *rw_file = SDL_RWFromFile(path, "rb");
+		if (rw_file == nullptr) {
+			this->log_error("Could not open file (%s): %s", path, SDL_GetError());
+			*file = nullptr;
+			return;
+		}
+
 		_SDL_Platform_File *platform_file = new _SDL_Platform_File();
-		platform_file->file = SDL_RWFromFile(path, "r");
-		platform_file->content_size = SDL_RWsize(platform_file->file) + 1;
-		platform_file->contents = (char *)malloc(sizeof(char) * platform_file->content_size);
-		SDL_RWread(platform_file->file, platform_file->contents, sizeof(char), platform_file->content_size);
+		platform_file->file = rw_file;
+		platform_file->content_size = (unsigned int)SDL_RWsize(platform_file->file);
 
-		// Add null character to the end of contents
-		platform_file->contents[platform_file->content_size - 1] = 0;
+		// Null terminated anyway for convenience, it isn't counted in the size.
+		char *contents = (char *)malloc(sizeof(char) * (platform_file->content_size + 1));
+		SDL_RWread(platform_file->file, contents, sizeof(char), platform_file->content_size);
+		contents[platform_file->content_size] = 0;
+		platform_file->contents = contents;
 
 		*file = (Platform_File *)platform_file;
 	}
 
-	void close_file(Platform_File **file) const override {
+	void close_file(Platform_File **file) const {
 		_SDL_Platform_File *platform_file = (_SDL_Platform_File *)*file;
-		free(platform_file->contents);
+		free((void *)platform_file->contents);
 		SDL_RWclose(platform_file->file);
 		delete platform_file;
 		*file = nullptr;
 	}
 
-	const std::string get_asset_path(const char *file_path) const override {
-		const std::string executable_location = SDL_GetBasePath();
-		const std::string asset_path = executable_location + "assets/" + file_path;
-		return asset_path;
+	const std::string get_asset_path(const char *file_path) const {
+		return this->base_path + "assets/" + file_path;
+	}
+
+	uint64_t get_monotonic_time_ns() const {
+		static const Uint64 frequency = SDL_GetPerformanceFrequency();
+		const Uint64 counter = SDL_GetPerformanceCounter();
+		return (uint64_t)(counter / frequency * 1000000000 + counter % frequency * 1000000000 / frequency);
+	}
+
+private:
+	static int save_thread_main(void *data) {
+		SDL_Platform *platform = (SDL_Platform *)data;
+
+		SDL_LockMutex(platform->save_mutex);
+		while (true) {
+			while (!platform->has_pending_save && !platform->is_closing) {
+				SDL_CondWait(platform->save_condition, platform->save_mutex);
+			}
+
+			if (!platform->has_pending_save) {
+				break;
+			}
+
+			Save_File::Buffer buffer;
+			Save_File::encode(platform->pending_save, buffer);
+			platform->has_pending_save = false;
+
+			SDL_UnlockMutex(platform->save_mutex);
+			if (!write_file_atomic(platform->save_file_path, platform->save_temp_file_path, buffer, sizeof(buffer))) {
+				platform->log_error("Could not write save file (%s).", platform->save_file_path.c_str());
+			}
+			SDL_LockMutex(platform->save_mutex);
+		}
+		SDL_UnlockMutex(platform->save_mutex);
+
+		return 0;
+	}
+
+	// Writes to a temporary file, flushes it to disk and renames it over the
+	// real file, so a crash mid-write leaves the previous save intact.
+	static bool write_file_atomic(const std::string &path, const std::string &temp_path, const uint8_t *data, size_t length) {
+		FILE *file = fopen(temp_path.c_str(), "wb");
+		if (file == nullptr) {
+			return false;
+		}
+
+		bool success = fwrite(data, 1, length, file) == length && fflush(file) == 0;
+
+		#ifdef _WIN32
+		success = success && _commit(_fileno(file)) == 0;
+		#else
+		success = success && fsync(fileno(file)) == 0;
+		#endif
+
+		success = fclose(file) == 0 && success;
+		if (!success) {
+			return false;
+		}
+
+		#ifdef _WIN32
+		return MoveFileExA(temp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+		#else
+		return rename(temp_path.c_str(), path.c_str()) == 0;
+		#endif
 	}
 };
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+
+// Picks the vector instruction set available for the target. Code using it 
+// should always keep a scalar fallback for when neither is defined.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SIMD_SSE 1
+	#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define SIMD_NEON 1
+	#include <arm_neon.h>
+#endif
\ No newline at end of file
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <thread>
+
+#include <SDL2/SDL.h>
+
+#include "allocation_tracker.hpp"
+#include "debug_state.hpp"
+#include "game.hpp"
+#include "game_clock.hpp"
+#include "game_events.hpp"
+#include "game_rules.hpp"
+#include "game_state.hpp"
+#include "input.hpp"
+#include "logger.hpp"
+#include "persistent_game_state.hpp"
+#include "profiler.hpp"
+#include "native_platform.hpp"
+#include "platform.hpp"
+#include "ring_buffer.hpp"
+#include "audio_player.hpp"
+#include "triple_buffer.hpp"
+#include "tuning.hpp"
+
+// What the render thread needs from the simulation for a frame.
+struct Simulation_Snapshot {
+	Game_State current;
+
+	// Changes whenever a new tick is published, so the renderer knows when to
+	// upload `sprites` again.
+	uint64_t tick_count = 0;
+	Sprites sprites;
+
+	// Real time that `current` corresponds to, and how much real time a tick
+	// takes at the current speed. Zero if the simulation is paused.
+	uint64_t tick_time_ns = 0;
+	uint64_t tick_duration_ns = 0;
+
+	bool has_debug_shapes = false;
+	Debug_Shapes debug_shapes;
+
+	float get_alpha(uint64_t time_ns) const {
+		if (this->tick_duration_ns == 0 || time_ns <= this->tick_time_ns) {
+			return this->tick_duration_ns == 0 ? 1.0f : 0.0f;
+		}
+
+		const float alpha = (float)((double)(time_ns - this->tick_time_ns) / this->tick_duration_ns);
+		return alpha < 1.0f ? alpha : 1.0f;
+	}
+};
+
+// Runs the fixed step simulation on its own thread. Input comes in through a
+// lock free queue and each completed batch of ticks is published through a
+// triple buffer, so neither thread ever waits on the other.
+//
+// Saves and sounds go through backends picked at compile time, so headless
+// runs swap in `Null_Storage` and `Null_Audio_Player` and never touch SDL.
+template<Storage_Backend Storage, Audio_Backend Audio>
+struct Simulation {
+	Game_State *game_state;
+	Game_State *previous_game_state;
+	Input *input;
+	Persistent_Game_State *persistent_game_state;
+	Debug_State *debug_state;
+	Storage *storage;
+	Audio *audio_player;
+	Game_Variant game_variant = Game_Variant::classic;
+
+	// Only used for the clock of the threaded simulation.
+	Native_Platform *platform;
+
+	// Only polled in debug builds, and only for `Game_Variant::tuned`.
+	Tuning_Watcher tuning_watcher;
+
+	// Filled by the render thread as events are pumped.
+	Spsc_Ring_Buffer<Input_Event, 64> input_events;
+	Triple_Buffer<Simulation_Snapshot> snapshots;
+
+	// Only safe to read once the thread has stopped.
+	Game_Clock game_clock;
+	Latency_Histogram flap_latency;
+	Allocation_Report tick_allocations;
+	Game_Telemetry telemetry;
+	Game_Event_History event_history;
+
+	bool start() {
+		Simulation_Snapshot initial_snapshot = {};
+		initial_snapshot.current = *this->game_state;
+		visit_game_rules(this->game_variant, [&](auto rules) {
+			Game<decltype(rules)>::populate_sprites(*this->game_state, *this->game_state, &initial_snapshot.sprites);
+		});
+		this->snapshots.fill(initial_snapshot);
+
+		this->running = true;
+		this->thread = SDL_CreateThread(thread_main, "Simulation", this);
+		if (this->thread == nullptr) {
+			LOG_ERROR("Could not create simulation thread: %s", SDL_GetError());
+			return false;
+		}
+
+		return true;
+	}
+
+	~Simulation() {
+		this->stop();
+	}
+
+	// Runs `tick_count` ticks back to back on the calling thread, as fast as
+	// they go. Time is simulated, so a run is repeatable for the same seed.
+	// Input holds the bird around the middle of the view, flapping whenever
+	// it falls to it. Nothing is drawn, so no snapshots are published.
+	void run_headless(uint64_t tick_count) {
+		uint64_t time_ns = 0;
+		this->game_clock.start(time_ns);
+		for (uint64_t tick_i = 0; tick_i < tick_count; tick_i++) {
+			time_ns += Game_Properties::sim_time_ns;
+			if (this->game_state->bird.position.y <= 0.0f && !this->input->flap) {
+				this->input_events.push({ .type = Input_Event::Type::down, .time_ns = time_ns });
+				this->input_events.push({ .type = Input_Event::Type::up, .time_ns = time_ns });
+			}
+			this->run_due_ticks(time_ns, false);
+		}
+	}
+
+	void stop() {
+		this->running = false;
+		if (this->thread != nullptr) {
+			SDL_WaitThread(this->thread, NULL);
+			this->thread = nullptr;
+		}
+	}
+
+private:
+	// Ticks before the steady state, where first use of the audio device and
+	// the like may still allocate.
+	static constexpr uint64_t allocation_warm_up_ticks = 60;
+
+	std::atomic<bool> running = false;
+	SDL_Thread *thread = nullptr;
+	Input_Queue input_queue;
+	Game_Events events;
+
+	static int thread_main(void *data) {
+		Simulation *simulation = (Simulation *)data;
+		PROFILE_THREAD("Simulation");
+		simulation->game_clock.start(simulation->platform->get_monotonic_time_ns());
+
+		while (simulation->running) {
+			simulation->run_due_ticks(simulation->platform->get_monotonic_time_ns(), true);
+			simulation->wait_for_next_tick();
+		}
+
+		return 0;
+	}
+
+	void run_due_ticks(uint64_t time_ns, bool should_publish) {
+		Input_Event event;
+		while (this->input_events.pop(&event)) {
+			this->input_queue.push(event);
+		}
+
+		if (this->debug_state != nullptr && this->debug_state->clear_high_score.exchange(false)) {
+			this->persistent_game_state->high_score = 0;
+			this->storage->save(*this->persistent_game_state);
+		}
+
+		#ifndef NDEBUG
+		if (this->game_variant == Game_Variant::tuned && this->tuning_watcher.poll(time_ns, &Tuned_Rules::tuning)) {
+			Game<Tuned_Rules>::apply_tuning(this->game_state);
+		}
+		#endif
+
+		const float sim_speed = this->debug_state != nullptr ? this->debug_state->sim_speed.load() : 1.0f;
+		const uint64_t tick_count = this->game_clock.advance(time_ns, sim_speed);
+
+		// Dispatched once per batch, so the ticks themselves run the variant's
+		// own code.
+		visit_game_rules(this->game_variant, [&](auto rules) {
+			this->run_ticks<decltype(rules)>(tick_count, sim_speed, should_publish);
+		});
+
+		if (this->debug_state != nullptr && tick_count > 0) {
+			this->debug_state->sim_time_ns.fetch_add(this->platform->get_monotonic_time_ns() - time_ns, std::memory_order_relaxed);
+		}
+	}
+
+	template<typename Rules>
+	void run_ticks(uint64_t tick_count, float sim_speed, bool should_publish) {
+		const uint64_t first_tick = this->game_clock.tick_count - tick_count;
+		uint64_t tick_time_ns = 0;
+		for (uint64_t tick_i = 0; tick_i < tick_count; tick_i++) {
+			const uint64_t allocations_before = Allocation_Tracker::get_thread_count();
+			tick_time_ns = this->game_clock.get_tick_time_ns(tick_i, tick_count);
+			this->input_queue.apply(this->input, tick_time_ns);
+
+			*this->previous_game_state = *this->game_state;
+			{
+				PROFILE_ZONE("Game::update");
+				Game<Rules>::update(
+					this->game_state,
+					this->input,
+					*this->persistent_game_state,
+					this->debug_state,
+					&this->events,
+					Game_Properties::sim_time_s
+				);
+			}
+			this->drain_events(first_tick + tick_i);
+
+			// Players without a device are mixed by the simulation instead.
+			if constexpr (requires(Audio *audio) { audio->render_offline(0.0f); }) {
+				if (this->audio_player->is_null()) {
+					this->audio_player->render_offline(Game_Properties::sim_time_s);
+				}
+			}
+
+			if (this->input->handled_flap_time_ns != 0) {
+				const uint64_t flap_time_ns = this->input->handled_flap_time_ns;
+				this->flap_latency.record(tick_time_ns > flap_time_ns ? tick_time_ns - flap_time_ns : 0);
+				this->input->handled_flap_time_ns = 0;
+			}
+
+			// The last tick of a batch is published, and building the snapshot
+			// counts towards it.
+			if (should_publish && tick_i + 1 == tick_count) {
+				this->publish<Rules>(tick_time_ns, sim_speed);
+			}
+
+			const uint64_t allocation_count = Allocation_Tracker::get_thread_count() - allocations_before;
+			if (first_tick + tick_i >= allocation_warm_up_ticks) {
+				this->tick_allocations.record(allocation_count);
+				assert(allocation_count == 0 && "The simulation allocated during a tick.");
+			}
+		}
+	}
+
+	// Every system that reacts to the game takes the tick's events in one go.
+	void drain_events(uint64_t tick) {
+		PROFILE_ZONE("Drain events");
+		const std::span<const Game_Event> events = this->events.view();
+		play_game_events(events, this->audio_player);
+		save_game_events(events, this->persistent_game_state, this->storage);
+		this->telemetry.record(events);
+		this->event_history.record(tick, events);
+
+		// Debug builds sum up every run as it ends, so runs can be compared
+		// from the log.
+		#ifndef NDEBUG
+		Game_Event_History::Run_Summary run;
+		for (const Game_Event &event : events) {
+			if (event.type == Game_Event_Type::reset && this->event_history.get_last_run(&run)) {
+				LOG_DEBUG(
+					"Run ended at tick %u: score %i%s, %u flaps over %u ticks, hit at tick %u%s",
+					run.end_tick,
+					run.score,
+					run.is_new_high_score ? " (new high score)" : "",
+					run.flap_count,
+					run.end_tick - run.start_tick,
+					run.hit_tick,
+					run.is_complete ? "" : " (start overwritten)"
+				);
+			}
+		}
+		#endif
+	}
+
+	template<typename Rules>
+	void publish(uint64_t tick_time_ns, float sim_speed) {
+		PROFILE_ZONE("Publish");
+		Simulation_Snapshot &snapshot = this->snapshots.get_write_slot();
+		snapshot.current = *this->game_state;
+		snapshot.tick_count = this->game_clock.tick_count;
+		{
+			PROFILE_ZONE("Game::populate_sprites");
+			Game<Rules>::populate_sprites(*this->game_state, *this->previous_game_state, &snapshot.sprites);
+		}
+		snapshot.tick_time_ns = tick_time_ns;
+		snapshot.tick_duration_ns = sim_speed > 0.0f ? (uint64_t)(Game_Properties::sim_time_ns / sim_speed) : 0;
+
+		snapshot.has_debug_shapes = this->debug_state != nullptr;
+		if (snapshot.has_debug_shapes) {
+			snapshot.debug_shapes = this->debug_state->debug_shapes;
+		}
+
+		this->snapshots.publish();
+	}
+
+	void wait_for_next_tick() {
+		const float sim_speed = this->debug_state != nullptr ? this->debug_state->sim_speed.load() : 1.0f;
+		if (sim_speed <= 0.0f) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			return;
+		}
+
+		const uint64_t sim_ns_until_tick = Game_Properties::sim_time_ns - this->game_clock.accumulator_ns;
+		std::this_thread::sleep_for(std::chrono::nanoseconds((uint64_t)(sim_ns_until_tick / sim_speed)));
+	}
+};
\ No newline at end of file
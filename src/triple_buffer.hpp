@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock free handoff of whole values from one writer thread to one reader
+// thread. The writer fills its own slot and publishes it by swapping it with
+// the shared middle slot. The reader swaps its slot with the middle one only
+// when something new has been published. Neither side ever waits, and the
+// reader always sees the newest complete value.
+template<typename T>
+struct Triple_Buffer {
+	// Sets every slot so the reader has something to use before the first
+	// publish. Must be called before either thread starts.
+	void fill(const T &value) {
+		for (T &slot : this->slots) {
+			slot = value;
+		}
+	}
+
+	T &get_write_slot() {
+		return this->slots[this->write_index];
+	}
+
+	void publish() {
+		const uint8_t previous_middle = this->middle.exchange(this->write_index | new_bit, std::memory_order_acq_rel);
+		this->write_index = previous_middle & index_mask;
+	}
+
+	// Returns the newest published value. The reference stays valid and
+	// unchanged until the next call.
+	T &read() {
+		if (this->middle.load(std::memory_order_relaxed) & new_bit) {
+			const uint8_t previous_middle = this->middle.exchange(this->read_index, std::memory_order_acq_rel);
+			this->read_index = previous_middle & index_mask;
+		}
+
+		return this->slots[this->read_index];
+	}
+
+private:
+	static constexpr uint8_t index_mask = 0b011;
+	static constexpr uint8_t new_bit = 0b100;
+
+	T slots[3];
+
+	// Each index is only touched by its own thread.
+	alignas(64) std::atomic<uint8_t> middle = 1;
+	alignas(64) uint8_t write_index = 0;
+	alignas(64) uint8_t read_index = 2;
+};
\ No newline at end of file
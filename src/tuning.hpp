@@ -0,0 +1,260 @@
+#pragma once
+
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <sys/stat.h>
+
+#include "assets.hpp"
+#include "game_properties.hpp"
+#include "game_rules.hpp"
+#include "logger.hpp"
+
+// Tuning profiles are plain text, one `name = value` per line, with `#`
+// starting a comment. Names are the fields of `Tuning`, such as
+// `bird.gravity` or `pipe.y_spacing`. Anything not listed keeps the value it
+// had before the profile was read.
+namespace Tuning_Profile {
+	constexpr size_t max_file_size = 4096;
+
+	struct Field {
+		const char *name;
+		size_t offset;
+	};
+
+	inline const Field fields[] = {
+		{ "bird.gravity", offsetof(Tuning, bird.gravity) },
+		{ "bird.flap_force", offsetof(Tuning, bird.flap_force) },
+		{ "bird.hovering_scale", offsetof(Tuning, bird.hovering_scale) },
+		{ "pipe.y_range", offsetof(Tuning, pipe.y_range) },
+		{ "pipe.x_spacing", offsetof(Tuning, pipe.x_spacing) },
+		{ "pipe.y_spacing", offsetof(Tuning, pipe.y_spacing) },
+		{ "cloud.x_min", offsetof(Tuning, cloud.x_min) },
+		{ "cloud.x_max", offsetof(Tuning, cloud.x_max) },
+		{ "cloud.y_min", offsetof(Tuning, cloud.y_min) },
+		{ "cloud.y_max", offsetof(Tuning, cloud.y_max) },
+		{ "cloud.speed_scale_min", offsetof(Tuning, cloud.speed_scale_min) },
+		{ "cloud.speed_scale_max", offsetof(Tuning, cloud.speed_scale_max) },
+		{ "cloud.scale_min", offsetof(Tuning, cloud.scale_min) },
+		{ "cloud.scale_max", offsetof(Tuning, cloud.scale_max) },
+		{ "cloud.scroll_speed", offsetof(Tuning, cloud.scroll_speed) },
+		{ "cloud.scroll_modifier", offsetof(Tuning, cloud.scroll_modifier) },
+		{ "scroll_speed", offsetof(Tuning, scroll_speed) }
+	};
+
+	inline const Field *find_field(const char *name, size_t name_length) {
+		for (const Field &field : fields) {
+			if (strlen(field.name) == name_length && strncmp(field.name, name, name_length) == 0) {
+				return &field;
+			}
+		}
+		return nullptr;
+	}
+
+	// Reads every line it can, so one typo doesn't lose the rest of the
+	// profile. Returns false if any line was rejected.
+	inline bool parse(const char *text, size_t length, Tuning *tuning) {
+		bool success = true;
+		int line_number = 0;
+		const char *cursor = text;
+		const char *text_end = text + length;
+
+		while (cursor < text_end) {
+			line_number++;
+			const char *line_end = (const char *)memchr(cursor, '\n', text_end - cursor);
+			if (line_end == nullptr) {
+				line_end = text_end;
+			}
+
+			const char *comment = (const char *)memchr(cursor, '#', line_end - cursor);
+			const char *start = cursor;
+			const char *end = comment != nullptr ? comment : line_end;
+			cursor = line_end + 1;
+
+			while (start < end && isspace((unsigned char)*start)) {
+				start++;
+			}
+			while (end > start && isspace((unsigned char)end[-1])) {
+				end--;
+			}
+			if (start == end) {
+				continue;
+			}
+
+			const char *equals = (const char *)memchr(start, '=', end - start);
+			if (equals == nullptr) {
+				LOG_ERROR("Tuning line %i is missing '='.", line_number);
+				success = false;
+				continue;
+			}
+
+			const char *name_end = equals;
+			while (name_end > start && isspace((unsigned char)name_end[-1])) {
+				name_end--;
+			}
+
+			const Field *field = find_field(start, name_end - start);
+			if (field == nullptr) {
+				LOG_ERROR("Tuning line %i has an unknown name.", line_number);
+				success = false;
+				continue;
+			}
+
+			// Copied out so `strtof` stops at the end of the line.
+			char value_text[32] = {};
+			const size_t value_length = (size_t)(end - (equals + 1));
+			if (value_length >= sizeof(value_text)) {
+				LOG_ERROR("Tuning line %i has a value that is too long.", line_number);
+				success = false;
+				continue;
+			}
+			memcpy(value_text, equals + 1, value_length);
+
+			char *value_end;
+			const float value = strtof(value_text, &value_end);
+			while (isspace((unsigned char)*value_end)) {
+				value_end++;
+			}
+			if (value_end == value_text || *value_end != '\0' || !std::isfinite(value)) {
+				LOG_ERROR("Tuning line %i (%s) has a value that isn't a finite number.", line_number, field->name);
+				success = false;
+				continue;
+			}
+
+			*(float *)((uint8_t *)tuning + field->offset) = value;
+		}
+
+		return success;
+	}
+
+	// Catches profiles that read cleanly but would break the game, such as a
+	// range that is the wrong way round or pipes with no gap. Needs the pipe
+	// texture's size, so profiles are loaded after the assets.
+	inline bool validate(const Tuning &tuning) {
+		bool success = true;
+
+		const struct {
+			const char *name;
+			float min;
+			float max;
+		} ranges[] = {
+			{ "cloud.x", tuning.cloud.x_min, tuning.cloud.x_max },
+			{ "cloud.y", tuning.cloud.y_min, tuning.cloud.y_max },
+			{ "cloud.speed_scale", tuning.cloud.speed_scale_min, tuning.cloud.speed_scale_max },
+			{ "cloud.scale", tuning.cloud.scale_min, tuning.cloud.scale_max }
+		};
+		for (const auto &range : ranges) {
+			if (range.min > range.max) {
+				LOG_ERROR("Tuning %s_min is greater than %s_max.", range.name, range.name);
+				success = false;
+			}
+		}
+
+		const struct {
+			const char *name;
+			float value;
+		} positives[] = {
+			{ "bird.gravity", tuning.bird.gravity },
+			{ "bird.flap_force", tuning.bird.flap_force },
+			{ "bird.hovering_scale", tuning.bird.hovering_scale },
+			{ "pipe.y_spacing", tuning.pipe.y_spacing },
+			{ "cloud.scroll_speed", tuning.cloud.scroll_speed },
+			{ "scroll_speed", tuning.scroll_speed }
+		};
+		for (const auto &positive : positives) {
+			if (positive.value <= 0.0f) {
+				LOG_ERROR("Tuning %s must be greater than zero.", positive.name);
+				success = false;
+			}
+		}
+
+		// Pipes can't overlap, and a pipe recycled off the left of the view
+		// has to land off the right of it.
+		const float pipe_width = (float)Asset::get_texture(Asset::Texture_ID::pipe).width;
+		const float min_x_spacing = fmaxf(
+			pipe_width,
+			(Game_Properties::view.width + pipe_width) / Tuned_Rules::pipe_pair_count
+		);
+		if (tuning.pipe.x_spacing < min_x_spacing) {
+			LOG_ERROR("Tuning pipe.x_spacing must be at least %g.", min_x_spacing);
+			success = false;
+		}
+
+		return success;
+	}
+
+	// `tuning` is only written to if the whole profile was read cleanly and
+	// passes `validate`.
+	inline bool load(const char *path, Tuning *tuning) {
+		FILE *file = fopen(path, "rb");
+		if (file == nullptr) {
+			LOG_ERROR("Tuning profile (%s) could not be opened.", path);
+			return false;
+		}
+
+		char text[max_file_size];
+		const size_t length = fread(text, 1, sizeof(text), file);
+		const bool is_too_large = length == sizeof(text) && fgetc(file) != EOF;
+		fclose(file);
+		if (is_too_large) {
+			LOG_ERROR("Tuning profile (%s) is larger than %u bytes.", path, max_file_size);
+			return false;
+		}
+
+		Tuning parsed = *tuning;
+		if (!parse(text, length, &parsed) || !validate(parsed)) {
+			return false;
+		}
+
+		*tuning = parsed;
+		return true;
+	}
+
+	inline time_t get_modified_time(const char *path) {
+		struct stat file_stat;
+		return stat(path, &file_stat) == 0 ? file_stat.st_mtime : 0;
+	}
+};
+
+// Reloads a profile once it changes on disk. Polled rather than notified, so
+// it only ever costs a `stat` a second.
+struct Tuning_Watcher {
+	static constexpr uint64_t poll_interval_ns = 1000000000;
+
+	const char *path = nullptr;
+	time_t modified_time = 0;
+	uint64_t next_poll_ns = 0;
+
+	void watch(const char *path) {
+		this->path = path;
+		this->modified_time = Tuning_Profile::get_modified_time(path);
+	}
+
+	// True if `tuning` was reloaded, in which case the caller should re-apply
+	// it with `Game::apply_tuning`.
+	bool poll(uint64_t time_ns, Tuning *tuning) {
+		if (this->path == nullptr || time_ns < this->next_poll_ns) {
+			return false;
+		}
+		this->next_poll_ns = time_ns + poll_interval_ns;
+
+		const time_t modified_time = Tuning_Profile::get_modified_time(this->path);
+		if (modified_time == this->modified_time) {
+			return false;
+		}
+		this->modified_time = modified_time;
+
+		if (!Tuning_Profile::load(this->path, tuning)) {
+			return false;
+		}
+
+		LOG_INFO("Reloaded tuning profile (%s).", this->path);
+		return true;
+	}
+};
\ No newline at end of file